@@ -0,0 +1,148 @@
+"""Columnar export benchmark: encoding throughput and bytes per million events.
+
+Generates a synthetic day of library traffic (students entering and
+leaving through a few devices, sorted by ts as the export reads it) and
+writes it with the export's table specs from export.py. It reports rows
+per second and MB per million events for each table, next to the same rows
+as GET /attendance JSON and as Parquet with default settings (dictionary
+on everything, no delta encoding, snappy). Reading the files back checks
+that the encodings took. No database is involved; export.py reports the
+same figures for real runs, including the time spent in PostgreSQL.
+
+    pip install -r requirements-export.txt
+    python3 bench/columnar_export.py --events 1000000 --students 5000 --devices 8
+"""
+
+import argparse
+import datetime as dt
+import json
+import os
+import random
+import sys
+import tempfile
+import time
+import uuid
+
+import pyarrow as pa
+import pyarrow.parquet as pq
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+from export import ATTENDANCE, EVENTS_RAW, VISITS, write_table  # noqa: E402
+
+DAY = dt.datetime(2026, 10, 1, tzinfo=dt.timezone.utc)
+DAY_US = int(DAY.timestamp() * 1_000_000)
+BRANCHES = ["CSE", "ECE", "ME", "CE", "IT", "EE"]
+
+
+def synthesize(events, students, devices, seed):
+    """Each student's visits follow one another between 08:00 and 20:00,
+    entering and leaving through any device; one in fifty students is
+    still inside at the end of the day."""
+    rng = random.Random(seed)
+    admission = [f"24GCE{n:05d}" for n in range(students)]
+    device = [f"esp32-gate-{n:02d}" for n in range(devices)]
+    per_student = max(1, events // 2 // students)
+    slot_us = 12 * 3600 * 1_000_000 // per_student
+    taps = []
+    for adm in range(students):
+        t = DAY_US + 8 * 3600 * 1_000_000
+        for visit in range(per_student):
+            entry = t + rng.randrange(slot_us // 4)
+            taps.append((entry, adm, "entry", rng.randrange(devices)))
+            if visit < per_student - 1 or adm % 50:
+                taps.append((entry + rng.randrange(slot_us // 8, slot_us // 2), adm, "exit", rng.randrange(devices)))
+            t += slot_us
+    taps.sort()
+
+    attendance, raw = [], []
+    seq = [0] * devices
+    for i, (ts, adm, kind, dev) in enumerate(taps, 1):
+        event_id = uuid.UUID(int=rng.getrandbits(128), version=4).bytes
+        processed = ts + rng.randrange(20_000, 200_000)
+        seq[dev] += 1
+        attendance.append((ts, i, admission[adm], kind, device[dev], event_id, processed))
+        raw.append((ts, event_id, device[dev], admission[adm], f"gate-{dev // 2}", 1, seq[dev], processed))
+
+    # Pair like the export's visits query: each entry with the student's
+    # next event if that is an exit.
+    last = {}
+    visits = []
+    for ts, adm, kind, dev in taps:
+        if kind == "entry":
+            row = [ts, admission[adm], BRANCHES[adm % len(BRANCHES)], adm % 4 + 1, device[dev], None, None, None]
+            visits.append(row)
+            last[adm] = row
+        elif adm in last:
+            row = last.pop(adm)
+            row[5], row[6], row[7] = ts, device[dev], (ts - row[0]) // 1_000_000
+    return attendance, raw, [tuple(v) for v in visits]
+
+
+def batches(rows, size):
+    for i in range(0, len(rows), size):
+        yield rows[i:i + size]
+
+
+def json_size(attendance):
+    """Bytes GET /attendance would send for these rows."""
+    total = 0
+    for ts, row_id, adm, kind, dev, event_id, processed in attendance:
+        total += len(json.dumps({
+            "id": row_id, "event_id": str(uuid.UUID(bytes=event_id)), "admission_no": adm, "student_name": "Bench Student",
+            "event_type": kind, "ts": dt.datetime.fromtimestamp(ts / 1e6, dt.timezone.utc).isoformat(),
+            "device_id": dev,
+            "processed_at": dt.datetime.fromtimestamp(processed / 1e6, dt.timezone.utc).isoformat(),
+        })) + 2
+    return total
+
+
+def default_parquet_size(spec, rows, path):
+    pq.write_table(pa.Table.from_batches([spec.batch(rows)]), path)
+    return os.path.getsize(path)
+
+
+def encodings(path):
+    meta = pq.ParquetFile(path).metadata
+    found = {}
+    for i in range(meta.num_columns):
+        col = meta.row_group(0).column(i)
+        found[col.path_in_schema] = sorted(set(col.encodings) - {"RLE", "PLAIN"}) or ["PLAIN"]
+    return found
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--events", type=int, default=1_000_000)
+    p.add_argument("--students", type=int, default=5000)
+    p.add_argument("--devices", type=int, default=8)
+    p.add_argument("--batch", type=int, default=100_000)
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    attendance, raw, visits = synthesize(args.events, args.students, args.devices, args.seed)
+    events = len(attendance)
+    print(f"{events} events, {len(visits)} visits, {args.students} students, {args.devices} devices")
+
+    with tempfile.TemporaryDirectory() as out:
+        total_s = 0.0
+        for spec, rows in ((ATTENDANCE, attendance), (EVENTS_RAW, raw), (VISITS, visits)):
+            path = os.path.join(out, spec.name + ".parquet")
+            start = time.perf_counter()
+            written, size, open_visits = write_table(spec, batches(rows, args.batch), path)
+            elapsed = time.perf_counter() - start
+            total_s += elapsed
+            baseline = default_parquet_size(spec, rows, os.path.join(out, spec.name + ".default.parquet"))
+            print(f"{spec.name}: {written} rows in {elapsed:.2f} s ({written / elapsed:,.0f} rows/s), "
+                  f"{size * 1e6 / events / 1e6:.2f} MB per million events "
+                  f"(default Parquet {baseline * 1e6 / events / 1e6:.2f})"
+                  + (f", {open_visits} open" if spec is VISITS else ""))
+            for column, enc in encodings(path).items():
+                if column in spec.dictionary or column in spec.delta:
+                    print(f"    {column}: {', '.join(enc)}")
+
+        print(f"all tables: {events / total_s:,.0f} events/s")
+        print(f"GET /attendance JSON: {json_size(attendance) * 1e6 / events / 1e6:.2f} MB per million events")
+
+
+if __name__ == "__main__":
+    main()
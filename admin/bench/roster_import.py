@@ -0,0 +1,117 @@
+"""Roster import benchmark: POST /students/import against per-record calls.
+
+Generates a roster of synthetic students (admission numbers under a BENCH
+prefix so they do not collide with real ones), then loads it twice:
+
+  per-record  POST /students and POST /students/register-rfid for each of
+              the first --sample rows over one keep-alive connection, the
+              path scripts/register-rfid.js takes, extrapolated to the
+              full roster
+  bulk        the whole file in one POST /students/import, once as new
+              students and again as an update of the same rows
+
+A final bulk run with some duplicate admission numbers and RFID conflicts
+checks that errors are reported per row and nothing is applied.
+
+Run against a local admin API (python3 -m uvicorn main:app --port 8001):
+
+    python3 bench/roster_import.py --rows 50000 --sample 2000
+
+Remove the rows afterwards with
+    DELETE FROM students WHERE admission_no LIKE 'BENCH%';
+"""
+
+import argparse
+import http.client
+import json
+import time
+from urllib.parse import urlparse
+
+
+def roster_csv(rows, prefix, rfid_base, conflicts=0):
+    lines = ["admission_no,name,branch,year,rfid_uid"]
+    for i in range(rows):
+        lines.append(f"{prefix}{i:06d},Bench Student {i},BENCH-{i % 12},{i % 4 + 1},{rfid_base + i:014X}")
+    # Repeat an admission number, and reuse another row's UID.
+    for i in range(conflicts):
+        lines.append(f"{prefix}{i:06d},Duplicate {i},BENCH-0,1,{rfid_base + rows + i:014X}")
+        lines.append(f"{prefix}X{i:06d},Conflict {i},BENCH-0,1,{rfid_base + rows // 2 + i:014X}")
+    return ("\n".join(lines) + "\n").encode()
+
+
+class Api:
+    def __init__(self, base):
+        u = urlparse(base)
+        self.conn = http.client.HTTPConnection(u.hostname, u.port or 80, timeout=600)
+        self.prefix = u.path.rstrip("/")
+
+    def request(self, method, path, body, content_type):
+        self.conn.request(method, self.prefix + path, body, {"Content-Type": content_type})
+        resp = self.conn.getresponse()
+        return resp.status, resp.read()
+
+    def post_json(self, path, payload):
+        status, data = self.request("POST", path, json.dumps(payload), "application/json")
+        if status != 200:
+            raise RuntimeError(f"POST {path} failed: {status} {data[:200]!r}")
+
+    def import_csv(self, body, query=""):
+        status, data = self.request("POST", "/students/import?report=errors" + query, body, "text/csv")
+        if status not in (200, 422):
+            raise RuntimeError(f"import failed: {status} {data[:200]!r}")
+        return json.loads(data)
+
+
+def per_record(api, rows, prefix, rfid_base):
+    start = time.perf_counter()
+    for i in range(rows):
+        api.post_json("/students", {"admission_no": f"{prefix}{i:06d}", "name": f"Bench Student {i}",
+                                    "branch": f"BENCH-{i % 12}", "year": i % 4 + 1})
+        api.post_json("/students/register-rfid", {"admission_no": f"{prefix}{i:06d}",
+                                                  "rfid_uid": f"{rfid_base + i:014X}"})
+    return time.perf_counter() - start
+
+
+def bulk(api, body, query=""):
+    start = time.perf_counter()
+    result = api.import_csv(body, query)
+    return time.perf_counter() - start, result
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--url", default="http://localhost:8001")
+    p.add_argument("--rows", type=int, default=50000)
+    p.add_argument("--sample", type=int, default=2000, help="rows loaded one at a time")
+    p.add_argument("--conflicts", type=int, default=50)
+    args = p.parse_args()
+
+    api = Api(args.url)
+    run = int(time.time())
+    rfid_base = 0xBE000000000000 + (run % 0x10000) * 0x1000000
+
+    sample_s = per_record(api, args.sample, f"BENCHP{run}-", rfid_base + 0x800000)
+    per_row_ms = sample_s * 1000 / args.sample
+    print(f"per-record: {args.sample} rows in {sample_s:.1f} s, {per_row_ms:.2f} ms/row, "
+          f"~{per_row_ms * args.rows / 1000:.0f} s for {args.rows}")
+
+    body = roster_csv(args.rows, f"BENCHB{run}-", rfid_base)
+    print(f"roster: {args.rows} rows, {len(body) / 1e6:.1f} MB")
+    for label in ("bulk insert", "bulk update"):
+        elapsed, result = bulk(api, body)
+        if not result["applied"]:
+            raise RuntimeError(f"{label} not applied: {result['report'][:5]}")
+        print(f"{label}: {elapsed:.2f} s, {elapsed * 1000 / args.rows:.3f} ms/row "
+              f"({result['inserted']} inserted, {result['updated']} updated), "
+              f"{per_row_ms * args.rows / 1000 / elapsed:.0f}x per-record")
+
+    bad = roster_csv(args.rows, f"BENCHB{run}-", rfid_base, conflicts=args.conflicts)
+    elapsed, result = bulk(api, bad)
+    print(f"bulk with {2 * args.conflicts} bad rows: {elapsed:.2f} s, {result['errors']} errors reported, "
+          f"applied={result['applied']}")
+    if result["applied"] or result["errors"] != 2 * args.conflicts:
+        raise RuntimeError("conflicting roster was not rejected row by row")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+"""WebSocket fan-out benchmark for /ws/events.
+
+Connects hundreds of dashboard-like clients plus a few that never read
+(a frozen browser tab), then plays the gateway publisher: events at a fixed
+rate, batched per window and POSTed to /internal/events/batch over one
+keep-alive connection. Reports per-event delivery latency across the
+reading clients and how many stalled clients the server dropped.
+
+Run against a local admin API (python3 -m uvicorn main:app --port 8001):
+
+    python3 bench/ws_fanout.py --clients 500 --stalled 20 --rate 200 --duration 30
+"""
+
+import argparse
+import asyncio
+import http.client
+import json
+import statistics
+import time
+from urllib.parse import urlparse
+
+import websockets
+
+
+class Stats:
+    def __init__(self):
+        self.latencies_ms = []
+        self.received = 0
+        self.closed_fast = 0
+        self.failed = 0
+
+
+async def fast_client(uri, stats, ready, stop):
+    try:
+        ws = await websockets.connect(uri, max_queue=None, open_timeout=30)
+    except Exception:
+        stats.failed += 1
+        ready.release()
+        return
+    async with ws:
+        ready.release()
+        try:
+            while not stop.is_set():
+                try:
+                    raw = await asyncio.wait_for(ws.recv(), timeout=0.5)
+                except asyncio.TimeoutError:
+                    continue
+                now = time.time_ns()
+                msg = json.loads(raw)
+                events = msg["events"] if msg.get("type") == "attendance_batch" else [msg]
+                for ev in events:
+                    sent_ns = int(ev["event_id"].rsplit("-", 1)[1])
+                    stats.latencies_ms.append((now - sent_ns) / 1e6)
+                stats.received += len(events)
+        except websockets.ConnectionClosed:
+            stats.closed_fast += 1
+
+
+async def stalled_client(uri, stats, ready, stop):
+    # Stops reading once one message is buffered, so TCP backs up to the server.
+    try:
+        ws = await websockets.connect(uri, max_queue=1, open_timeout=30)
+    except Exception:
+        stats.failed += 1
+        ready.release()
+        return
+    async with ws:
+        ready.release()
+        await stop.wait()
+
+
+class Publisher:
+    """Single keep-alive HTTP connection, like the gateway's EventPublisher."""
+
+    def __init__(self, base_url):
+        u = urlparse(base_url)
+        self.conn = http.client.HTTPConnection(u.hostname, u.port or 80, timeout=10)
+        self.path = (u.path.rstrip("/") or "") + "/internal/events/batch"
+
+    def post(self, events):
+        body = json.dumps({"events": events})
+        self.conn.request("POST", self.path, body, {"Content-Type": "application/json"})
+        resp = self.conn.getresponse()
+        data = resp.read()
+        if resp.status != 200:
+            raise RuntimeError(f"batch POST failed: {resp.status} {data[:200]!r}")
+        return json.loads(data)
+
+
+async def publish(base_url, rate, window_ms, duration, result):
+    loop = asyncio.get_running_loop()
+    pub = Publisher(base_url)
+    seq = 0
+    per_window = rate * window_ms / 1000.0
+    owed = 0.0
+    deadline = time.monotonic() + duration
+    next_tick = time.monotonic()
+    while time.monotonic() < deadline:
+        owed += per_window
+        n = int(owed)
+        owed -= n
+        if n:
+            events = []
+            for _ in range(n):
+                seq += 1
+                events.append({
+                    "event_id": f"bench-{seq}-{time.time_ns()}",
+                    "device_id": "bench-device",
+                    "admission_no": f"BENCH{seq % 1000:04d}",
+                    "event_type": "entry" if seq % 2 else "exit",
+                    "ts": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+                })
+            t0 = time.perf_counter()
+            resp = await loop.run_in_executor(None, pub.post, events)
+            result["post_ms"].append((time.perf_counter() - t0) * 1000)
+            result["clients"].append(resp["clients"])
+        result["published"] = seq
+        next_tick += window_ms / 1000.0
+        await asyncio.sleep(max(0.0, next_tick - time.monotonic()))
+
+
+def pct(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100.0 * len(values)))]
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--url", default="http://localhost:8001", help="admin API base URL")
+    ap.add_argument("--clients", type=int, default=500, help="reading WebSocket clients")
+    ap.add_argument("--stalled", type=int, default=20, help="clients that stop reading")
+    ap.add_argument("--rate", type=float, default=200, help="events per second")
+    ap.add_argument("--window-ms", type=float, default=5, help="publisher batching window")
+    ap.add_argument("--duration", type=float, default=30, help="seconds to publish")
+    args = ap.parse_args()
+
+    ws_uri = args.url.replace("http", "ws", 1).rstrip("/") + "/ws/events"
+    stats = Stats()
+    stop = asyncio.Event()
+    ready = asyncio.Semaphore(0)
+    total = args.clients + args.stalled
+
+    tasks = []
+    connect_gate = asyncio.Semaphore(50)
+
+    async def spawn(coro):
+        async with connect_gate:
+            tasks.append(asyncio.create_task(coro))
+            await asyncio.sleep(0.005)
+
+    t0 = time.perf_counter()
+    await asyncio.gather(
+        *[spawn(fast_client(ws_uri, stats, ready, stop)) for _ in range(args.clients)],
+        *[spawn(stalled_client(ws_uri, stats, ready, stop)) for _ in range(args.stalled)],
+    )
+    for _ in range(total):
+        await ready.acquire()
+    print(f"connected {args.clients} reading + {args.stalled} stalled clients "
+          f"in {time.perf_counter() - t0:.1f}s ({stats.failed} failed)")
+
+    result = {"published": 0, "post_ms": [], "clients": []}
+    t0 = time.perf_counter()
+    await publish(args.url, args.rate, args.window_ms, args.duration, result)
+    await asyncio.sleep(1.0)  # let the last batch drain
+    elapsed = time.perf_counter() - t0
+    stop.set()
+    await asyncio.gather(*tasks, return_exceptions=True)
+
+    expected = result["published"] * args.clients
+    lat = stats.latencies_ms
+    print(f"published        {result['published']} events in {len(result['post_ms'])} batches "
+          f"({result['published'] / args.duration:.0f} events/s)")
+    print(f"delivered        {stats.received}/{expected} to reading clients "
+          f"({stats.received / elapsed:.0f} deliveries/s), {stats.closed_fast} reading clients closed")
+    print(f"latency ms       p50={pct(lat, 50):.1f} p99={pct(lat, 99):.1f} "
+          f"p99.9={pct(lat, 99.9):.1f} max={max(lat, default=0):.1f}")
+    print(f"batch POST ms    p50={pct(result['post_ms'], 50):.2f} p99={pct(result['post_ms'], 99):.2f} "
+          f"mean={statistics.fmean(result['post_ms']) if result['post_ms'] else 0:.2f}")
+    if result["clients"]:
+        print(f"server clients   start={result['clients'][0]} end={result['clients'][-1]} "
+              f"(stalled dropped: {total - result['clients'][-1]})")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
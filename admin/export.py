@@ -0,0 +1,360 @@
+"""Columnar export of attendance history for offline analytics.
+
+Writes one Parquet file per UTC day and table under --out:
+
+    attendance/day=2026-10-01/part.parquet   one row per attendance row
+    events_raw/day=2026-10-01/part.parquet   device events, with gate_id and seq pulled out of raw_json
+    visits/day=2026-10-01/part.parquet       entry/exit pairs by entry day, dwell_s precomputed
+
+admission_no, device_id and the other low-cardinality strings are
+dictionary-encoded; timestamps (microseconds since the epoch) and ids are
+delta-encoded, which with rows sorted by ts stores most of them in a few
+bits. Pages are zstd-compressed. The layout is Hive-style, so pyarrow,
+DuckDB or Spark read the whole tree as one dataset partitioned by day.
+
+Runs are incremental. _manifest.json under --out records the exported
+days and a processed_at watermark; a run exports the closed days after the
+last one, and re-exports earlier days that received rows since the
+watermark (events buffered on a device or in the gateway), along with the
+day before when it had visits that were still open. Each day is read in
+one REPEATABLE READ, read-only transaction with server-side cursors, so
+memory stays at one batch whatever the day's size. Point EXPORT_PG_URL at a
+replica to keep the load off the primary.
+
+    pip install -r requirements-export.txt
+    python3 export.py --out /srv/attendance-export
+    python3 export.py --out /srv/attendance-export --since 2026-09-01 --until 2026-09-30
+
+Each day and the run as a whole report rows per second and bytes per
+million events.
+"""
+
+import argparse
+import datetime as dt
+import json
+import os
+import sys
+import time
+
+import pyarrow as pa
+import pyarrow.parquet as pq
+
+BATCH_ROWS = int(os.getenv("EXPORT_BATCH_ROWS", "100000"))
+COMPRESSION = os.getenv("EXPORT_COMPRESSION", "zstd")
+MANIFEST = "_manifest.json"
+
+# Rows written within this long before a run started may not have committed
+# yet (processed_at is the transaction's start), so the watermark stays that
+# far behind.
+WATERMARK_LAG = dt.timedelta(minutes=1)
+
+# Visits are paired by entry day; an exit is looked for this far past the
+# end of the day.
+VISIT_LOOKAHEAD = dt.timedelta(days=1)
+
+TS = pa.timestamp("us", tz="UTC")
+# UUIDs as their 16 bytes; random ones do not compress, so text would
+# store each twice over.
+UUID = pa.binary(16)
+
+
+class TableSpec:
+    """A per-day output: its Arrow schema, which columns get a dictionary
+    and which are delta-encoded, and the query producing the rows. Timestamp
+    columns are selected as epoch microseconds so rows need no datetime
+    objects on the way through; bytea arrives as memoryview."""
+
+    def __init__(self, name, fields, dictionary, delta, query):
+        self.name = name
+        self.schema = pa.schema(fields)
+        self.dictionary = dictionary
+        self.delta = delta
+        self.query = query
+
+    def writer(self, path):
+        return pq.ParquetWriter(
+            path, self.schema,
+            compression=COMPRESSION,
+            use_dictionary=self.dictionary,
+            column_encoding={name: "DELTA_BINARY_PACKED" for name in self.delta},
+        )
+
+    def batch(self, rows):
+        columns = list(zip(*rows))
+        arrays = []
+        for field, values in zip(self.schema, columns):
+            if pa.types.is_timestamp(field.type):
+                arrays.append(pa.array(values, type=pa.int64()).cast(field.type))
+            elif field.type == UUID:
+                arrays.append(pa.array([bytes(v) for v in values], type=field.type))
+            else:
+                arrays.append(pa.array(values, type=field.type))
+        return pa.RecordBatch.from_arrays(arrays, schema=self.schema)
+
+
+def epoch_us(column):
+    return f"(extract(epoch FROM {column}) * 1000000)::bigint"
+
+
+ATTENDANCE = TableSpec(
+    "attendance",
+    [
+        ("ts", TS),
+        ("id", pa.int64()),
+        ("admission_no", pa.string()),
+        ("event_type", pa.string()),
+        ("device_id", pa.string()),
+        ("event_id", UUID),
+        ("processed_at", TS),
+    ],
+    dictionary=["admission_no", "event_type", "device_id"],
+    delta=["ts", "id", "processed_at"],
+    query=f"""
+        SELECT {epoch_us('ts')}, id, admission_no, event_type, device_id, uuid_send(event_id), {epoch_us('processed_at')}
+        FROM attendance
+        WHERE ts >= %(start)s AND ts < %(end)s
+        ORDER BY ts, id
+    """,
+)
+
+EVENTS_RAW = TableSpec(
+    "events_raw",
+    [
+        ("ts", TS),
+        ("event_id", UUID),
+        ("device_id", pa.string()),
+        ("admission_no", pa.string()),
+        ("gate_id", pa.string()),
+        ("seq_epoch", pa.int64()),
+        ("seq", pa.int64()),
+        ("created_at", TS),
+    ],
+    dictionary=["device_id", "admission_no", "gate_id"],
+    delta=["ts", "seq", "created_at"],
+    query=f"""
+        SELECT {epoch_us('ts')}, uuid_send(event_id), device_id, admission_no, raw_json->>'gate_id',
+               (raw_json->>'seq_epoch')::bigint, (raw_json->>'seq')::bigint, {epoch_us('created_at')}
+        FROM events_raw
+        WHERE ts >= %(start)s AND ts < %(end)s
+        ORDER BY ts
+    """,
+)
+
+# An entry pairs with the student's next event when that is an exit; an
+# entry followed by another entry, or by nothing yet, is an open visit with
+# no exit_ts or dwell_s.
+VISITS = TableSpec(
+    "visits",
+    [
+        ("entry_ts", TS),
+        ("admission_no", pa.string()),
+        ("branch", pa.string()),
+        ("year", pa.int16()),
+        ("entry_device_id", pa.string()),
+        ("exit_ts", TS),
+        ("exit_device_id", pa.string()),
+        ("dwell_s", pa.int32()),
+    ],
+    dictionary=["admission_no", "branch", "entry_device_id", "exit_device_id"],
+    delta=["entry_ts"],
+    query=f"""
+        WITH ev AS (
+            SELECT admission_no, event_type, ts, device_id,
+                   lead(event_type) OVER w AS next_type,
+                   lead(ts) OVER w AS next_ts,
+                   lead(device_id) OVER w AS next_device_id
+            FROM attendance
+            WHERE ts >= %(start)s AND ts < %(end)s + %(lookahead)s
+            WINDOW w AS (PARTITION BY admission_no ORDER BY ts, id)
+        )
+        SELECT {epoch_us('ev.ts')}, ev.admission_no, s.branch, s.year, ev.device_id,
+               CASE WHEN next_type = 'exit' THEN {epoch_us('next_ts')} END,
+               CASE WHEN next_type = 'exit' THEN next_device_id END,
+               CASE WHEN next_type = 'exit' THEN extract(epoch FROM next_ts - ev.ts)::int END
+        FROM ev
+        JOIN students s ON s.admission_no = ev.admission_no
+        WHERE ev.event_type = 'entry' AND ev.ts < %(end)s
+        ORDER BY ev.ts
+    """,
+)
+
+TABLES = [ATTENDANCE, EVENTS_RAW, VISITS]
+
+
+def day_path(out, table, day):
+    return os.path.join(out, table, f"day={day.isoformat()}", "part.parquet")
+
+
+class DayStats:
+    def __init__(self):
+        self.rows = {}
+        self.bytes = {}
+        self.open_visits = 0
+        self.seconds = 0.0
+
+    @property
+    def events(self):
+        return self.rows.get("attendance", 0)
+
+
+def write_table(spec, batches, path):
+    """Write batches (lists of row tuples) to path through a temporary file,
+    so readers never see a half-written day. Returns (rows, bytes, open
+    visits)."""
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    # Dot-prefixed, so dataset readers skip it.
+    tmp = os.path.join(os.path.dirname(path), "." + os.path.basename(path) + ".tmp")
+    rows = open_visits = 0
+    writer = spec.writer(tmp)
+    try:
+        for chunk in batches:
+            batch = spec.batch(chunk)
+            writer.write_batch(batch)
+            rows += batch.num_rows
+            if spec is VISITS:
+                open_visits += batch.column("exit_ts").null_count
+    finally:
+        writer.close()
+    os.replace(tmp, path)
+    return rows, os.path.getsize(path), open_visits
+
+
+def stream(conn, spec, params):
+    with conn.cursor(name=f"export_{spec.name}") as cur:
+        cur.itersize = BATCH_ROWS
+        cur.execute(spec.query, params)
+        while True:
+            chunk = cur.fetchmany(BATCH_ROWS)
+            if not chunk:
+                return
+            yield chunk
+
+
+def export_day(conn, out, day):
+    start = dt.datetime.combine(day, dt.time(), tzinfo=dt.timezone.utc)
+    params = {"start": start, "end": start + dt.timedelta(days=1), "lookahead": VISIT_LOOKAHEAD}
+    stats = DayStats()
+    began = time.perf_counter()
+    conn.set_session(isolation_level="REPEATABLE READ", readonly=True)
+    try:
+        for spec in TABLES:
+            rows, size, open_visits = write_table(spec, stream(conn, spec, params), day_path(out, spec.name, day))
+            stats.rows[spec.name] = rows
+            stats.bytes[spec.name] = size
+            stats.open_visits += open_visits
+    finally:
+        conn.rollback()
+    stats.seconds = time.perf_counter() - began
+    return stats
+
+
+def load_manifest(out):
+    try:
+        with open(os.path.join(out, MANIFEST)) as f:
+            return json.load(f)
+    except FileNotFoundError:
+        return {"watermark": None, "days": {}}
+
+
+def save_manifest(out, manifest):
+    path = os.path.join(out, MANIFEST)
+    with open(path + ".tmp", "w") as f:
+        json.dump(manifest, f, indent=1, sort_keys=True)
+    os.replace(path + ".tmp", path)
+
+
+def days_to_export(conn, manifest, since, until):
+    """Closed days after the last exported one, plus exported days that
+    received rows since the watermark, plus the day before any of those
+    that still had open visits."""
+    exported = {dt.date.fromisoformat(d): v for d, v in manifest["days"].items()}
+    with conn.cursor() as cur:
+        if since is None:
+            if exported:
+                since = max(exported) + dt.timedelta(days=1)
+            else:
+                cur.execute("SELECT (min(ts) AT TIME ZONE 'UTC')::date FROM attendance")
+                since = cur.fetchone()[0] or until + dt.timedelta(days=1)
+        days = set()
+        day = since
+        while day <= until:
+            days.add(day)
+            day += dt.timedelta(days=1)
+
+        if exported and manifest["watermark"]:
+            # Served by idx_attendance_processed_at.
+            cur.execute(
+                """SELECT DISTINCT (ts AT TIME ZONE 'UTC')::date FROM attendance
+                   WHERE processed_at > %s AND ts < %s""",
+                (manifest["watermark"], dt.datetime.combine(max(exported) + dt.timedelta(days=1), dt.time(),
+                                                            tzinfo=dt.timezone.utc)),
+            )
+            days.update(d for (d,) in cur.fetchall() if d in exported)
+        conn.rollback()
+
+    for day in list(days):
+        before = day - dt.timedelta(days=1)
+        if exported.get(before, {}).get("open_visits"):
+            days.add(before)
+    return sorted(d for d in days if d <= until)
+
+
+def per_million(size, events):
+    return size * 1_000_000 / events if events else 0
+
+
+def main():
+    p = argparse.ArgumentParser(description="Export attendance history to per-day Parquet files.")
+    p.add_argument("--out", required=True, help="output directory")
+    p.add_argument("--since", type=dt.date.fromisoformat, help="first day (default: after the last exported day)")
+    p.add_argument("--until", type=dt.date.fromisoformat, help="last day (default: yesterday, UTC)")
+    args = p.parse_args()
+
+    import psycopg2
+
+    pg_url = os.getenv("EXPORT_PG_URL") or os.getenv("PG_URL")
+    if not pg_url:
+        sys.exit("EXPORT_PG_URL or PG_URL must be set")
+    until = args.until or dt.datetime.now(dt.timezone.utc).date() - dt.timedelta(days=1)
+
+    os.makedirs(args.out, exist_ok=True)
+    manifest = load_manifest(args.out)
+    conn = psycopg2.connect(pg_url)
+    try:
+        with conn.cursor() as cur:
+            cur.execute("SELECT now() - %s", (WATERMARK_LAG,))
+            watermark = cur.fetchone()[0]
+        conn.rollback()
+
+        days = days_to_export(conn, manifest, args.since, until)
+        if not days:
+            print("Nothing to export")
+        total = DayStats()
+        for day in days:
+            stats = export_day(conn, args.out, day)
+            manifest["days"][day.isoformat()] = {
+                "rows": stats.rows, "bytes": stats.bytes, "open_visits": stats.open_visits,
+            }
+            # Saved per day so an interrupted run resumes where it stopped.
+            save_manifest(args.out, manifest)
+            for name in stats.rows:
+                total.rows[name] = total.rows.get(name, 0) + stats.rows[name]
+                total.bytes[name] = total.bytes.get(name, 0) + stats.bytes[name]
+            total.seconds += stats.seconds
+            print(f"{day}: {stats.events} events, {stats.rows['visits']} visits "
+                  f"({stats.open_visits} open), {sum(stats.bytes.values()) / 1e6:.2f} MB in {stats.seconds:.1f} s")
+    finally:
+        conn.close()
+
+    manifest["watermark"] = watermark.isoformat()
+    save_manifest(args.out, manifest)
+    if days and total.events:
+        print(f"\n{len(days)} day(s), {total.events} events in {total.seconds:.1f} s "
+              f"({total.events / total.seconds:,.0f} events/s)")
+        for name in total.rows:
+            print(f"  {name}: {total.rows[name]} rows, "
+                  f"{per_million(total.bytes[name], total.events) / 1e6:.2f} MB per million events")
+
+
+if __name__ == "__main__":
+    main()
@@ -3,10 +3,11 @@
 import { useEffect, useMemo, useState } from "react"
 import { Users, Clock, AlertTriangle, UserCheck } from "lucide-react"
 import {
-  fetchAttendance,
+  AttendanceFeed,
   fetchStudents,
   fetchUnassignedRFIDs,
   fetchCurrentAttendance,
+  fetchAnalyticsSummary,
   registerRFID,
   AttendanceWebSocket,
   type AttendanceRecord,
@@ -16,6 +17,9 @@ import {
   type AttendanceEvent,
 } from "@/lib/api"
 let wsClient: AttendanceWebSocket | null = null
+// Every WebSocket batch refreshes the recent list; the feed fetches only the
+// rows written since the last refresh.
+const recentAttendance = new AttendanceFeed(8)
 
 export default function Dashboard() {
   const [attendance, setAttendance] = useState<AttendanceRecord[]>([])
@@ -51,11 +55,12 @@ export default function Dashboard() {
       wsClient = new AttendanceWebSocket()
       wsClient.connect()
 
-      const unsubscribe = wsClient.onEvent((event) => {
-        setLastEvent(event)
+      const unsubscribe = wsClient.onEvents((events) => {
+        setLastEvent(events[events.length - 1])
         loadAttendance(true)
         loadUnassigned()
         loadCurrent()
+        loadSummary()
       })
 
       return () => {
@@ -65,15 +70,6 @@ export default function Dashboard() {
     }
   }, [])
 
-  const calculateTodayCheckIns = (records: AttendanceRecord[]) => {
-    const today = new Date().toISOString().split("T")[0]
-    return records.filter((record) => {
-      if (!record.ts) return false
-      const normalized = new Date(record.ts).toISOString().split("T")[0]
-      return normalized === today && record.event_type === "entry" && record.admission_no !== "UNKNOWN"
-    }).length
-  }
-
   const loadUnassigned = async (initial?: UnassignedRFID[]) => {
     if (initial) {
       setUnassignedRFIDs(initial)
@@ -114,18 +110,19 @@ export default function Dashboard() {
   const loadData = async () => {
     try {
       setLoading(true)
-      const [attendanceData, studentsData, unassignedData, currentData] = await Promise.all([
-        fetchAttendance({ limit: 8 }),
+      const [attendanceData, studentsData, unassignedData, currentData, summary] = await Promise.all([
+        recentAttendance.refresh(),
         fetchStudents(),
         fetchUnassignedRFIDs(),
         fetchCurrentAttendance(),
+        fetchAnalyticsSummary(),
       ])
       setAttendance(attendanceData)
       loadStudents(studentsData)
       setStats({
         totalStudents: studentsData.length,
-        todayCheckIns: calculateTodayCheckIns(attendanceData),
-        currentlyPresent: currentData.length,
+        todayCheckIns: summary.today_entries,
+        currentlyPresent: summary.inside,
       })
       loadUnassigned(unassignedData)
       setCurrentAttendance(currentData)
@@ -141,12 +138,8 @@ export default function Dashboard() {
       if (!skipLoader) {
         setLoading(true)
       }
-      const data = await fetchAttendance({ limit: 8 })
+      const data = await recentAttendance.refresh()
       setAttendance(data)
-      setStats((prev) => ({
-        ...prev,
-        todayCheckIns: calculateTodayCheckIns(data),
-      }))
     } catch (error) {
       console.error("Failed to load attendance:", error)
     } finally {
@@ -160,12 +153,21 @@ export default function Dashboard() {
     try {
       const data = await fetchCurrentAttendance()
       setCurrentAttendance(data)
+    } catch (error) {
+      console.error("Failed to load current attendance:", error)
+    }
+  }
+
+  const loadSummary = async () => {
+    try {
+      const summary = await fetchAnalyticsSummary()
       setStats((prev) => ({
         ...prev,
-        currentlyPresent: data.length,
+        todayCheckIns: summary.today_entries,
+        currentlyPresent: summary.inside,
       }))
     } catch (error) {
-      console.error("Failed to load current attendance:", error)
+      console.error("Failed to load analytics summary:", error)
     }
   }
 
@@ -0,0 +1,460 @@
+#include "rc522.h"
+
+#include <inttypes.h>
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "RC522";
+
+// MFRC522 register map 
+#define RC522_REG_COMMAND          0x01
+#define RC522_REG_COMM_IE          0x02
+#define RC522_REG_COMM_IRQ         0x04
+#define RC522_REG_DIV_IRQ          0x05
+#define RC522_REG_ERROR            0x06
+#define RC522_REG_STATUS1          0x07
+#define RC522_REG_FIFO_DATA        0x09
+#define RC522_REG_FIFO_LEVEL       0x0A
+#define RC522_REG_CONTROL          0x0C
+#define RC522_REG_BIT_FRAMING      0x0D
+#define RC522_REG_MODE             0x11
+#define RC522_REG_TX_CONTROL       0x14
+#define RC522_REG_TX_ASK           0x15
+#define RC522_REG_CRC_RESULT_L     0x22
+#define RC522_REG_CRC_RESULT_H     0x21
+#define RC522_REG_RFCFG            0x26
+#define RC522_REG_T_MODE           0x2A
+#define RC522_REG_T_PRESCALER      0x2B
+#define RC522_REG_T_RELOAD_L       0x2D
+#define RC522_REG_T_RELOAD_H       0x2C
+#define RC522_REG_VERSION          0x37
+
+// MFRC522 command set 
+#define RC522_CMD_IDLE             0x00
+#define RC522_CMD_CALC_CRC         0x03
+#define RC522_CMD_TRANSCEIVE       0x0C
+#define RC522_CMD_SOFT_RESET       0x0F
+
+// ISO14443A commands
+#define PICC_REQIDL                0x26
+#define PICC_REQALL                0x52
+#define PICC_ANTICOLL_CL1          0x93
+
+// Consecutive transport faults before the chip is reset and reconfigured
+#define RC522_RECOVER_AFTER_FAULTS 3
+// rc522_configure() value of TModeReg; reads back 0x00 after a silent brown-out reset
+#define RC522_T_MODE_VALUE         0x8D
+
+// Return the error from an RC522 step instead of aborting the firmware.
+#define RC522_CHECK(x) do {                 \
+        esp_err_t rc522_err_ = (x);         \
+        if (rc522_err_ != ESP_OK) {         \
+            return rc522_err_;              \
+        }                                   \
+    } while (0)
+
+// Low-level SPI helpers mapped from the Lua reference implementation
+static esp_err_t rc522_write_reg(rc522_t *r, uint8_t reg, uint8_t value) {
+    if (!r->spi) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_transaction_t t = {
+        .flags = SPI_TRANS_USE_TXDATA,
+        .length = 16,
+    };
+    t.tx_data[0] = (uint8_t)((reg << 1) & 0x7E);
+    t.tx_data[1] = value;
+    return spi_device_transmit(r->spi, &t);
+}
+
+static esp_err_t rc522_read_reg(rc522_t *r, uint8_t reg, uint8_t *value) {
+    if (!r->spi || !value) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_transaction_t t = {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = 16,
+    };
+    t.tx_data[0] = (uint8_t)(((reg << 1) & 0x7E) | 0x80);
+    t.tx_data[1] = 0x00;
+    esp_err_t ret = spi_device_transmit(r->spi, &t);
+    if (ret == ESP_OK) {
+        *value = t.rx_data[1];
+    }
+    return ret;
+}
+
+static esp_err_t rc522_set_bitmask(rc522_t *r, uint8_t reg, uint8_t mask) {
+    uint8_t value;
+    RC522_CHECK(rc522_read_reg(r, reg, &value));
+    return rc522_write_reg(r, reg, value | mask);
+}
+
+static esp_err_t rc522_clear_bitmask(rc522_t *r, uint8_t reg, uint8_t mask) {
+    uint8_t value;
+    RC522_CHECK(rc522_read_reg(r, reg, &value));
+    return rc522_write_reg(r, reg, value & (uint8_t)(~mask));
+}
+
+static esp_err_t rc522_calculate_crc(rc522_t *r, const uint8_t *data, size_t length, uint8_t *result) {
+    RC522_CHECK(rc522_clear_bitmask(r, RC522_REG_DIV_IRQ, 0x04));
+    RC522_CHECK(rc522_set_bitmask(r, RC522_REG_FIFO_LEVEL, 0x80));
+
+    for (size_t i = 0; i < length; i++) {
+        RC522_CHECK(rc522_write_reg(r, RC522_REG_FIFO_DATA, data[i]));
+    }
+
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_COMMAND, RC522_CMD_CALC_CRC));
+
+    int i = 0xFF;
+    uint8_t n = 0;
+    do {
+        RC522_CHECK(rc522_read_reg(r, RC522_REG_DIV_IRQ, &n));
+        i--;
+    } while (i != 0 && !(n & 0x04));
+
+    if (i == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    RC522_CHECK(rc522_read_reg(r, RC522_REG_CRC_RESULT_L, &result[0]));
+    RC522_CHECK(rc522_read_reg(r, RC522_REG_CRC_RESULT_H, &result[1]));
+    return ESP_OK;
+}
+
+static esp_err_t rc522_transceive(rc522_t *r, const uint8_t *send_data,
+                                  size_t send_len,
+                                  uint8_t *back_data,
+                                  size_t *back_bits) {
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_COMM_IE, 0x77 | 0x80));
+    RC522_CHECK(rc522_clear_bitmask(r, RC522_REG_COMM_IRQ, 0x80));
+    RC522_CHECK(rc522_set_bitmask(r, RC522_REG_FIFO_LEVEL, 0x80));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_COMMAND, RC522_CMD_IDLE));
+
+    for (size_t i = 0; i < send_len; i++) {
+        RC522_CHECK(rc522_write_reg(r, RC522_REG_FIFO_DATA, send_data[i]));
+    }
+
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_COMMAND, RC522_CMD_TRANSCEIVE));
+    RC522_CHECK(rc522_set_bitmask(r, RC522_REG_BIT_FRAMING, 0x80));
+
+    int iterations = 2000;
+    uint8_t irq_status = 0;
+    do {
+        RC522_CHECK(rc522_read_reg(r, RC522_REG_COMM_IRQ, &irq_status));
+        iterations--;
+    } while (iterations && !(irq_status & 0x01) && !(irq_status & 0x30));
+
+    RC522_CHECK(rc522_clear_bitmask(r, RC522_REG_BIT_FRAMING, 0x80));
+
+    if (iterations == 0) {
+        // Neither the timer nor the receiver fired: the chip is not running.
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint8_t error = 0;
+    RC522_CHECK(rc522_read_reg(r, RC522_REG_ERROR, &error));
+    if (error & 0x1B) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (!(irq_status & 0x30)) {
+        // Receive timer expired with nothing heard: no card in the field.
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (back_data && back_bits) {
+        uint8_t length = 0;
+        uint8_t last_bits = 0;
+        RC522_CHECK(rc522_read_reg(r, RC522_REG_FIFO_LEVEL, &length));
+        RC522_CHECK(rc522_read_reg(r, RC522_REG_CONTROL, &last_bits));
+        last_bits &= 0x07;
+
+        if (last_bits != 0) {
+            *back_bits = (size_t)((length - 1) * 8 + last_bits);
+        } else {
+            *back_bits = (size_t)(length * 8);
+        }
+
+        for (uint8_t i = 0; i < length && i < MFRC522_MAX_LEN; i++) {
+            RC522_CHECK(rc522_read_reg(r, RC522_REG_FIFO_DATA, &back_data[i]));
+        }
+    }
+
+    return ESP_OK;
+}
+
+// ESP_OK when a card answered, ESP_ERR_NOT_FOUND when the field is empty.
+static esp_err_t rc522_request(rc522_t *r, uint8_t req_mode) {
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_BIT_FRAMING, 0x07));
+    uint8_t back_data[MFRC522_MAX_LEN] = {0};
+    size_t back_bits = 0;
+    RC522_CHECK(rc522_transceive(r, &req_mode, 1, back_data, &back_bits));
+    if (back_bits == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (back_bits != 0x10) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rc522_anticoll(rc522_t *r, uint8_t *serial, size_t *serial_len) {
+    uint8_t command[] = {PICC_ANTICOLL_CL1, 0x20};
+    uint8_t back_data[MFRC522_MAX_LEN] = {0};
+    size_t back_bits = 0;
+
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_BIT_FRAMING, 0x00));
+
+    RC522_CHECK(rc522_transceive(r, command, sizeof(command), back_data, &back_bits));
+
+    if (back_bits != 0x28) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    uint8_t check = 0;
+    for (int i = 0; i < 4; i++) {
+        serial[i] = back_data[i];
+        check ^= back_data[i];
+    }
+
+    if (check != back_data[4]) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    serial[4] = back_data[4];
+    if (serial_len) {
+        *serial_len = 5;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rc522_halt(rc522_t *r) {
+    uint8_t buffer[4] = {0x50, 0x00, 0x00, 0x00};
+    uint8_t crc[2] = {0};
+    esp_err_t err = rc522_calculate_crc(r, buffer, 2, crc);
+    if (err != ESP_OK) {
+        return err;
+    }
+    buffer[2] = crc[0];
+    buffer[3] = crc[1];
+    // A halted card does not answer, so silence is success.
+    err = rc522_transceive(r, buffer, sizeof(buffer), NULL, NULL);
+    return err == ESP_ERR_NOT_FOUND ? ESP_OK : err;
+}
+
+esp_err_t rc522_get_tag(rc522_t *r, uint8_t *uid, size_t *uid_len) {
+    if (!r->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    RC522_CHECK(rc522_request(r, PICC_REQIDL));
+
+    size_t serial_length = 0;
+    RC522_CHECK(rc522_anticoll(r, uid, &serial_length));
+
+    esp_err_t halt_err = rc522_halt(r);
+    if (halt_err != ESP_OK) {
+        // The UID is already valid; only note the failure.
+        ESP_LOGW(TAG, "[%s] RFID halt failed (%s)", r->cfg.gate_id, esp_err_to_name(halt_err));
+    }
+
+    if (uid_len) {
+        *uid_len = serial_length;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rc522_antenna_on(rc522_t *r) {
+    uint8_t value;
+    RC522_CHECK(rc522_read_reg(r, RC522_REG_TX_CONTROL, &value));
+    if (!(value & 0x03)) {
+        RC522_CHECK(rc522_set_bitmask(r, RC522_REG_TX_CONTROL, 0x03));
+    }
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_RFCFG, 0x60));
+    return ESP_OK;
+}
+
+esp_err_t rc522_antenna_off(rc522_t *r) {
+    return rc522_clear_bitmask(r, RC522_REG_TX_CONTROL, 0x03);
+}
+
+// A card halted after a read only answers WUPA. A card left in READY state
+// ignores one WUPA and drops back to IDLE, so try twice before deciding the
+// field is empty.
+esp_err_t rc522_card_present(rc522_t *r) {
+    if (!r->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = rc522_request(r, PICC_REQALL);
+    if (err == ESP_ERR_NOT_FOUND || err == ESP_ERR_INVALID_RESPONSE) {
+        err = rc522_request(r, PICC_REQALL);
+    }
+    return err;
+}
+
+static esp_err_t rc522_reset_sequence(rc522_t *r) {
+    if (r->cfg.rst_pin >= 0) {
+        gpio_config_t rst_conf = {
+            .pin_bit_mask = 1ULL << r->cfg.rst_pin,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_down_en = 0,
+            .pull_up_en = 0,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        RC522_CHECK(gpio_config(&rst_conf));
+
+        gpio_set_level(r->cfg.rst_pin, 0);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        gpio_set_level(r->cfg.rst_pin, 1);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_COMMAND, RC522_CMD_SOFT_RESET));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    return ESP_OK;
+}
+
+static esp_err_t rc522_configure(rc522_t *r) {
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_T_MODE, RC522_T_MODE_VALUE));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_T_PRESCALER, 0x3E));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_T_RELOAD_L, 30));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_T_RELOAD_H, 0));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_TX_ASK, 0x40));
+    RC522_CHECK(rc522_write_reg(r, RC522_REG_MODE, 0x3D));
+    return rc522_antenna_on(r);
+}
+
+static esp_err_t rc522_check_version(rc522_t *r) {
+    uint8_t version = 0;
+    esp_err_t version_err = rc522_read_reg(r, RC522_REG_VERSION, &version);
+    if (version_err != ESP_OK) {
+        ESP_LOGE(TAG, "[%s] Failed to read MFRC522 version register: %s", r->cfg.gate_id, esp_err_to_name(version_err));
+        return version_err;
+    }
+
+    ESP_LOGI(TAG, "[%s] MFRC522 version register: 0x%02X", r->cfg.gate_id, version);
+    if (version == 0x00 || version == 0xFF) {
+        ESP_LOGE(TAG, "[%s] Invalid MFRC522 version response. Expected 0x90/0x91/0x92. Check SPI wiring (SCK/MOSI/MISO/SDA) and power.", r->cfg.gate_id);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rc522_bus_init(spi_host_device_t host, int mosi_io, int miso_io, int sck_io) {
+    spi_bus_config_t buscfg = {
+        .mosi_io_num = mosi_io,
+        .miso_io_num = miso_io,
+        .sclk_io_num = sck_io,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = 0,
+        .flags = 0,
+    };
+
+    esp_err_t ret = spi_bus_initialize(host, &buscfg, SPI_DMA_CH_AUTO);
+    return ret == ESP_ERR_INVALID_STATE ? ESP_OK : ret;
+}
+
+esp_err_t rc522_attach(rc522_t *r, spi_host_device_t host, const rc522_config_t *cfg) {
+    if (r->spi != NULL) {
+        return ESP_OK;
+    }
+    r->cfg = *cfg;
+
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = 5 * 1000 * 1000,
+        .mode = 0,
+        .spics_io_num = cfg->cs_pin,
+        .queue_size = 1,
+        .flags = 0, // full-duplex transactions (required for register reads)
+    };
+
+    return spi_bus_add_device(host, &devcfg, &r->spi);
+}
+
+esp_err_t rc522_init(rc522_t *r) {
+    if (r->initialized) {
+        return ESP_OK;
+    }
+    if (r->spi == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    RC522_CHECK(rc522_reset_sequence(r));
+    RC522_CHECK(rc522_configure(r));
+    RC522_CHECK(rc522_check_version(r));
+
+    r->initialized = true;
+    ESP_LOGI(TAG, "[%s] MFRC522 ready (direct SPI mode)", r->cfg.gate_id);
+    return ESP_OK;
+}
+
+static bool rc522_is_fault(esp_err_t err) {
+    return err != ESP_OK && err != ESP_ERR_NOT_FOUND && err != ESP_ERR_INVALID_RESPONSE;
+}
+
+// Reset and reconfigure the chip in place, without touching the SPI bus.
+static esp_err_t rc522_recover(rc522_t *r) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = rc522_reset_sequence(r);
+    if (err == ESP_OK) {
+        err = rc522_configure(r);
+    }
+    if (err == ESP_OK) {
+        err = rc522_check_version(r);
+    }
+    r->consecutive_faults = 0;
+
+    if (err != ESP_OK) {
+        r->health.recovery_failures++;
+        ESP_LOGE(TAG, "[%s] MFRC522 recovery failed: %s (failures=%" PRIu32 ")",
+                 r->cfg.gate_id, esp_err_to_name(err), r->health.recovery_failures);
+        return err;
+    }
+    r->health.recoveries++;
+    ESP_LOGW(TAG, "[%s] MFRC522 recovered in %lld ms (recoveries=%" PRIu32 ")",
+             r->cfg.gate_id, (long long)((esp_timer_get_time() - start_us) / 1000), r->health.recoveries);
+    return ESP_OK;
+}
+
+bool rc522_supervise(rc522_t *r, esp_err_t err) {
+    if (err == ESP_ERR_INVALID_RESPONSE) {
+        r->health.protocol_errors++;
+    }
+    if (!rc522_is_fault(err)) {
+        r->consecutive_faults = 0;
+        return false;
+    }
+
+    r->health.transport_errors++;
+    if (++r->consecutive_faults == 1 || r->health.transport_errors % 20 == 1) {
+        ESP_LOGW(TAG, "[%s] RFID transport error (%s). Failure count=%" PRIu32,
+                 r->cfg.gate_id, esp_err_to_name(err), r->health.transport_errors);
+    }
+    if (r->consecutive_faults < RC522_RECOVER_AFTER_FAULTS) {
+        return false;
+    }
+    rc522_recover(r);
+    return true;
+}
+
+// A brown-out can reset the chip without any SPI error; its registers then
+// read back as power-on defaults and every poll looks like an empty field.
+bool rc522_health_check(rc522_t *r) {
+    uint8_t t_mode = 0;
+    esp_err_t err = rc522_read_reg(r, RC522_REG_T_MODE, &t_mode);
+    if (err == ESP_OK && t_mode != RC522_T_MODE_VALUE) {
+        ESP_LOGW(TAG, "[%s] MFRC522 lost its configuration (TModeReg=0x%02X)", r->cfg.gate_id, t_mode);
+        r->health.transport_errors++;
+        rc522_recover(r);
+        return true;
+    }
+    return rc522_supervise(r, err);
+}
+
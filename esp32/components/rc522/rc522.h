@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/spi_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest FIFO read; UID buffers passed to rc522_get_tag must be this size.
+#define MFRC522_MAX_LEN            18
+
+// Time for the PCD field to power a card after the antenna is switched on
+#define RC522_ANTENNA_SETTLE_MS    5
+
+// How often an idle reader should run rc522_health_check()
+#define RC522_HEALTH_CHECK_MS      5000
+
+typedef struct {
+    const char *gate_id; // reported with each scan, e.g. "entry" or "exit"
+    int cs_pin;          // SDA/SS; each reader on the bus needs its own
+    int rst_pin;         // -1 when RST is tied high: soft reset only
+} rc522_config_t;
+
+// Outcome counters for one reader. ESP_ERR_NOT_FOUND (no card) is the normal
+// idle result and is not counted.
+typedef struct {
+    uint32_t transport_errors;   // SPI failures, unresponsive or reset chip
+    uint32_t protocol_errors;    // garbled frames, collisions, bad BCC
+    uint32_t recoveries;         // in-place resets that brought the chip back
+    uint32_t recovery_failures;
+} rc522_health_t;
+
+// One MFRC522 on a shared SPI bus. Zero-initialise, then rc522_attach().
+typedef struct {
+    rc522_config_t cfg;
+    spi_device_handle_t spi;
+    bool initialized;
+    uint32_t consecutive_faults;
+    rc522_health_t health;
+} rc522_t;
+
+// Initialise the shared bus; succeeds if it is already initialised.
+esp_err_t rc522_bus_init(spi_host_device_t host, int mosi_io, int miso_io, int sck_io);
+
+// Add the reader to the bus. Attach every reader before talking to any of
+// them so all chip selects are driven high.
+esp_err_t rc522_attach(rc522_t *r, spi_host_device_t host, const rc522_config_t *cfg);
+
+// Reset, configure and probe the chip. Safe to retry after a failure.
+esp_err_t rc522_init(rc522_t *r);
+
+// ESP_OK with the UID filled in, ESP_ERR_NOT_FOUND when no card is present,
+// anything else is a protocol or transport error for rc522_supervise().
+esp_err_t rc522_get_tag(rc522_t *r, uint8_t *uid, size_t *uid_len);
+
+// ESP_OK while a (halted) card is still in the field, ESP_ERR_NOT_FOUND once it has left.
+esp_err_t rc522_card_present(rc522_t *r);
+
+esp_err_t rc522_antenna_on(rc522_t *r);
+esp_err_t rc522_antenna_off(rc522_t *r);
+
+// Account for the result of one operation and reset the chip in place after
+// repeated transport faults. Returns true if a recovery was attempted, which
+// leaves the antenna on.
+bool rc522_supervise(rc522_t *r, esp_err_t err);
+
+// Detect a chip that silently lost its configuration; same return as rc522_supervise().
+bool rc522_health_check(rc522_t *r);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,103 @@
+#include "rfid_sched.h"
+
+#include <string.h>
+
+static bool profile_covers(const rfid_sched_profile_t *p, int hour) {
+    if (p->start_hour <= p->end_hour) {
+        return hour >= p->start_hour && hour < p->end_hour;
+    }
+    // Window wraps past midnight.
+    return hour >= p->start_hour || hour < p->end_hour;
+}
+
+void rfid_sched_init(rfid_sched_t *s, const rfid_sched_config_t *cfg, int64_t now_ms) {
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (s->cfg.removal_misses == 0) {
+        s->cfg.removal_misses = 1;
+    }
+    s->interval_ms = cfg->fallback.fast_ms;
+    // Start "hot" so the first minute after boot polls quickly.
+    s->last_card_ms = now_ms;
+    s->antenna_on = true;
+    s->antenna_on_since_ms = now_ms;
+}
+
+const rfid_sched_profile_t *rfid_sched_profile(const rfid_sched_t *s, int hour) {
+    if (hour >= 0) {
+        for (size_t i = 0; i < s->cfg.profile_count; i++) {
+            if (profile_covers(&s->cfg.profiles[i], hour)) {
+                return &s->cfg.profiles[i];
+            }
+        }
+    }
+    return &s->cfg.fallback;
+}
+
+uint32_t rfid_sched_on_idle_poll(rfid_sched_t *s, int64_t now_ms, int hour) {
+    const rfid_sched_profile_t *p = rfid_sched_profile(s, hour);
+    s->stats.polls++;
+
+    if (now_ms - s->last_card_ms < (int64_t)s->cfg.hot_window_ms) {
+        s->interval_ms = p->fast_ms;
+        return s->interval_ms;
+    }
+
+    uint32_t next = s->interval_ms < p->fast_ms ? p->fast_ms : s->interval_ms * 2;
+    if (next > p->idle_max_ms) {
+        next = p->idle_max_ms;
+    }
+    s->interval_ms = next;
+    return next;
+}
+
+void rfid_sched_on_card(rfid_sched_t *s, int64_t now_ms) {
+    s->stats.polls++;
+    s->stats.cards++;
+    s->last_card_ms = now_ms;
+    s->awaiting_removal = true;
+    s->misses = 0;
+}
+
+bool rfid_sched_on_removal_check(rfid_sched_t *s, bool present, int64_t now_ms) {
+    if (!s->awaiting_removal) {
+        return true;
+    }
+    if (present) {
+        s->misses = 0;
+        s->last_card_ms = now_ms;
+        return false;
+    }
+    if (++s->misses < s->cfg.removal_misses) {
+        return false;
+    }
+    s->awaiting_removal = false;
+    s->misses = 0;
+    s->last_card_ms = now_ms;
+    s->interval_ms = 0; // resume at fast_ms of the active profile
+    return true;
+}
+
+bool rfid_sched_antenna_may_idle(const rfid_sched_t *s) {
+    return !s->awaiting_removal && s->interval_ms >= s->cfg.antenna_off_threshold_ms;
+}
+
+void rfid_sched_antenna_changed(rfid_sched_t *s, bool on, int64_t now_ms) {
+    if (on == s->antenna_on) {
+        return;
+    }
+    if (on) {
+        s->antenna_on_since_ms = now_ms;
+    } else {
+        s->stats.radio_on_ms += (uint64_t)(now_ms - s->antenna_on_since_ms);
+    }
+    s->antenna_on = on;
+}
+
+rfid_sched_stats_t rfid_sched_stats(const rfid_sched_t *s, int64_t now_ms) {
+    rfid_sched_stats_t out = s->stats;
+    if (s->antenna_on) {
+        out.radio_on_ms += (uint64_t)(now_ms - s->antenna_on_since_ms);
+    }
+    return out;
+}
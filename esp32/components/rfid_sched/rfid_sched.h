@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Polling policy for one RC522 antenna. Plain C with no ESP-IDF dependencies
+// so the same code runs in esp32/host/rfid_sched_sim.c.
+
+typedef struct {
+    uint8_t start_hour;      // inclusive, local time
+    uint8_t end_hour;        // exclusive; may wrap past midnight (e.g. 22 -> 7)
+    uint32_t fast_ms;        // poll interval while cards were seen recently
+    uint32_t idle_max_ms;    // ceiling for the exponential idle back-off
+} rfid_sched_profile_t;
+
+typedef struct {
+    const rfid_sched_profile_t *profiles;
+    size_t profile_count;
+    rfid_sched_profile_t fallback;     // used when no profile matches or the clock is unset
+    uint32_t hot_window_ms;            // stay at fast_ms this long after the last card
+    uint32_t antenna_off_threshold_ms; // switch the antenna off for intervals >= this
+    uint32_t removal_check_ms;         // interval between "card still there?" checks
+    uint8_t removal_misses;            // consecutive misses before a card counts as removed
+} rfid_sched_config_t;
+
+typedef struct {
+    uint64_t polls;
+    uint64_t cards;
+    uint64_t radio_on_ms;
+} rfid_sched_stats_t;
+
+typedef struct {
+    rfid_sched_config_t cfg;
+    uint32_t interval_ms;
+    int64_t last_card_ms;
+    bool awaiting_removal;
+    uint8_t misses;
+    bool antenna_on;
+    int64_t antenna_on_since_ms;
+    rfid_sched_stats_t stats;
+} rfid_sched_t;
+
+void rfid_sched_init(rfid_sched_t *s, const rfid_sched_config_t *cfg, int64_t now_ms);
+
+// Profile in effect for a local hour (0-23); hour < 0 means the clock is not set.
+const rfid_sched_profile_t *rfid_sched_profile(const rfid_sched_t *s, int hour);
+
+// Record a poll that found no card and return the delay before the next one.
+uint32_t rfid_sched_on_idle_poll(rfid_sched_t *s, int64_t now_ms, int hour);
+
+// Record a card read. The caller should switch to removal checks until
+// rfid_sched_on_removal_check() reports the card has left the field.
+void rfid_sched_on_card(rfid_sched_t *s, int64_t now_ms);
+
+// Record the result of a removal check; returns true once the card is gone.
+bool rfid_sched_on_removal_check(rfid_sched_t *s, bool present, int64_t now_ms);
+
+// Whether the antenna may be switched off until the next poll.
+bool rfid_sched_antenna_may_idle(const rfid_sched_t *s);
+
+// Radio-on accounting; call whenever the antenna is switched.
+void rfid_sched_antenna_changed(rfid_sched_t *s, bool on, int64_t now_ms);
+
+// Snapshot of the counters with radio_on_ms brought up to now_ms.
+rfid_sched_stats_t rfid_sched_stats(const rfid_sched_t *s, int64_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
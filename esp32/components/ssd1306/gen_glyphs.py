@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Generate ssd1306_glyphs.h from the 5x7 font below.
+
+Each printable ASCII glyph is emitted pre-expanded at 1x, 2x and 3x: 6*s
+columns (the spacing column included) by s display pages, page-major, so a
+glyph's bytes for one page are contiguous and ssd1306.c copies them into the
+frame buffer with one memcpy per page. Column bytes are LSB-top, as the
+SSD1306 reads them. Scaling doubles or triples every column and every row.
+
+Run by the component's CMakeLists.txt at build time:
+    python3 gen_glyphs.py <output.h>
+"""
+
+import sys
+
+FIRST = 32
+SCALES = (1, 2, 3)
+
+# Columns of each glyph from ' ' (32) to '~' (126); bit 0 is the top row.
+FONT_5X7 = [
+    (0x00, 0x00, 0x00, 0x00, 0x00), (0x00, 0x00, 0x5F, 0x00, 0x00), (0x00, 0x07, 0x00, 0x07, 0x00),
+    (0x14, 0x7F, 0x14, 0x7F, 0x14), (0x24, 0x2A, 0x7F, 0x2A, 0x12), (0x23, 0x13, 0x08, 0x64, 0x62),
+    (0x36, 0x49, 0x55, 0x22, 0x50), (0x00, 0x05, 0x03, 0x00, 0x00), (0x00, 0x1C, 0x22, 0x41, 0x00),
+    (0x00, 0x41, 0x22, 0x1C, 0x00), (0x14, 0x08, 0x3E, 0x08, 0x14), (0x08, 0x08, 0x3E, 0x08, 0x08),
+    (0x00, 0x50, 0x30, 0x00, 0x00), (0x08, 0x08, 0x08, 0x08, 0x08), (0x00, 0x60, 0x60, 0x00, 0x00),
+    (0x20, 0x10, 0x08, 0x04, 0x02), (0x3E, 0x51, 0x49, 0x45, 0x3E), (0x00, 0x42, 0x7F, 0x40, 0x00),
+    (0x42, 0x61, 0x51, 0x49, 0x46), (0x21, 0x41, 0x45, 0x4B, 0x31), (0x18, 0x14, 0x12, 0x7F, 0x10),
+    (0x27, 0x45, 0x45, 0x45, 0x39), (0x3C, 0x4A, 0x49, 0x49, 0x30), (0x01, 0x71, 0x09, 0x05, 0x03),
+    (0x36, 0x49, 0x49, 0x49, 0x36), (0x06, 0x49, 0x49, 0x29, 0x1E), (0x00, 0x36, 0x36, 0x00, 0x00),
+    (0x00, 0x56, 0x36, 0x00, 0x00), (0x08, 0x14, 0x22, 0x41, 0x00), (0x14, 0x14, 0x14, 0x14, 0x14),
+    (0x00, 0x41, 0x22, 0x14, 0x08), (0x02, 0x01, 0x51, 0x09, 0x06), (0x32, 0x49, 0x79, 0x41, 0x3E),
+    (0x7E, 0x11, 0x11, 0x11, 0x7E), (0x7F, 0x49, 0x49, 0x49, 0x36), (0x3E, 0x41, 0x41, 0x41, 0x22),
+    (0x7F, 0x41, 0x41, 0x22, 0x1C), (0x7F, 0x49, 0x49, 0x49, 0x41), (0x7F, 0x09, 0x09, 0x09, 0x01),
+    (0x3E, 0x41, 0x49, 0x49, 0x7A), (0x7F, 0x08, 0x08, 0x08, 0x7F), (0x00, 0x41, 0x7F, 0x41, 0x00),
+    (0x20, 0x40, 0x41, 0x3F, 0x01), (0x7F, 0x10, 0x28, 0x44, 0x00), (0x7F, 0x40, 0x40, 0x40, 0x40),
+    (0x7F, 0x02, 0x0C, 0x02, 0x7F), (0x7F, 0x04, 0x08, 0x10, 0x7F), (0x3E, 0x41, 0x41, 0x41, 0x3E),
+    (0x7F, 0x09, 0x09, 0x09, 0x06), (0x3E, 0x41, 0x51, 0x21, 0x5E), (0x7F, 0x09, 0x19, 0x29, 0x46),
+    (0x46, 0x49, 0x49, 0x49, 0x31), (0x01, 0x01, 0x7F, 0x01, 0x01), (0x3F, 0x40, 0x40, 0x40, 0x3F),
+    (0x1F, 0x20, 0x40, 0x20, 0x1F), (0x3F, 0x40, 0x38, 0x40, 0x3F), (0x63, 0x14, 0x08, 0x14, 0x63),
+    (0x07, 0x08, 0x70, 0x08, 0x07), (0x61, 0x51, 0x49, 0x45, 0x43), (0x00, 0x7F, 0x41, 0x41, 0x00),
+    (0x02, 0x04, 0x08, 0x10, 0x20), (0x00, 0x41, 0x41, 0x7F, 0x00), (0x04, 0x02, 0x01, 0x02, 0x04),
+    (0x40, 0x40, 0x40, 0x40, 0x40), (0x00, 0x01, 0x02, 0x04, 0x00), (0x20, 0x54, 0x54, 0x54, 0x78),
+    (0x7F, 0x48, 0x44, 0x44, 0x38), (0x38, 0x44, 0x44, 0x44, 0x20), (0x38, 0x44, 0x44, 0x48, 0x7F),
+    (0x38, 0x54, 0x54, 0x54, 0x18), (0x08, 0x7E, 0x09, 0x01, 0x02), (0x0C, 0x52, 0x52, 0x52, 0x3E),
+    (0x7F, 0x08, 0x04, 0x04, 0x78), (0x00, 0x44, 0x7D, 0x40, 0x00), (0x20, 0x40, 0x44, 0x3D, 0x00),
+    (0x7F, 0x10, 0x28, 0x44, 0x00), (0x00, 0x41, 0x7F, 0x40, 0x00), (0x7C, 0x04, 0x18, 0x04, 0x78),
+    (0x7C, 0x08, 0x04, 0x04, 0x78), (0x38, 0x44, 0x44, 0x44, 0x38), (0x7C, 0x14, 0x14, 0x14, 0x08),
+    (0x08, 0x14, 0x14, 0x18, 0x7C), (0x7C, 0x08, 0x04, 0x04, 0x08), (0x48, 0x54, 0x54, 0x54, 0x20),
+    (0x04, 0x3F, 0x44, 0x40, 0x20), (0x3C, 0x40, 0x40, 0x20, 0x7C), (0x1C, 0x20, 0x40, 0x20, 0x1C),
+    (0x3C, 0x40, 0x30, 0x40, 0x3C), (0x44, 0x28, 0x10, 0x28, 0x44), (0x0C, 0x50, 0x50, 0x50, 0x3C),
+    (0x44, 0x64, 0x54, 0x4C, 0x44), (0x00, 0x08, 0x36, 0x41, 0x00), (0x00, 0x00, 0x7F, 0x00, 0x00),
+    (0x00, 0x41, 0x36, 0x08, 0x00), (0x10, 0x08, 0x08, 0x10, 0x08),
+]
+
+
+def scale_glyph(columns, s):
+    """Pages (top first) of 6*s column bytes for one glyph at scale s."""
+    pages = [[] for _ in range(s)]
+    for col in columns + (0x00,):
+        tall = 0
+        for row in range(8):
+            if col >> row & 1:
+                tall |= ((1 << s) - 1) << (row * s)
+        for page in range(s):
+            pages[page].extend([tall >> (8 * page) & 0xFF] * s)
+    return pages
+
+
+def render(out):
+    lines = [
+        "// Generated by components/ssd1306/gen_glyphs.py; do not edit.",
+        "#pragma once",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define SSD1306_GLYPH_FIRST {FIRST}",
+        f"#define SSD1306_GLYPH_COUNT {len(FONT_5X7)}",
+    ]
+    for s in SCALES:
+        lines += ["", f"static const uint8_t ssd1306_glyphs_{s}x[SSD1306_GLYPH_COUNT][{s}][{6 * s}] = {{"]
+        for code, columns in enumerate(FONT_5X7):
+            pages = ", ".join("{" + ",".join(f"0x{b:02X}" for b in page) + "}" for page in scale_glyph(columns, s))
+            lines.append(f"    {{{pages}}}, // {chr(FIRST + code)!r}")
+        lines.append("};")
+    out.write("\n".join(lines) + "\n")
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: gen_glyphs.py <output.h>")
+    with open(sys.argv[1], "w") as out:
+        render(out)
+
+
+if __name__ == "__main__":
+    main()
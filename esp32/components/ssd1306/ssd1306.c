@@ -1,5 +1,6 @@
 #include "ssd1306.h"
 #include <string.h>
+#include "ssd1306_glyphs.h"
 #include "driver/i2c_master.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -10,46 +11,21 @@ static const char *TAG = "SSD1306";
 static i2c_master_bus_handle_t i2c_bus = NULL;
 static i2c_master_dev_handle_t i2c_dev = NULL;
 static SemaphoreHandle_t ssd1306_mutex = NULL;
+static StaticSemaphore_t ssd1306_mutex_buf;
 static bool ssd1306_initialized = false;
 
-#define SSD1306_WIDTH 128
-#define SSD1306_HEIGHT 64
-#define SSD1306_PAGE_COUNT (SSD1306_HEIGHT / 8)
-
-static const uint8_t font5x7[95][5] = {
-    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00},
-    {0x14,0x7F,0x14,0x7F,0x14}, {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62},
-    {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, {0x00,0x1C,0x22,0x41,0x00},
-    {0x00,0x41,0x22,0x1C,0x00}, {0x14,0x08,0x3E,0x08,0x14}, {0x08,0x08,0x3E,0x08,0x08},
-    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00},
-    {0x20,0x10,0x08,0x04,0x02}, {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00},
-    {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, {0x18,0x14,0x12,0x7F,0x10},
-    {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
-    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00},
-    {0x00,0x56,0x36,0x00,0x00}, {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14},
-    {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, {0x32,0x49,0x79,0x41,0x3E},
-    {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
-    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01},
-    {0x3E,0x41,0x49,0x49,0x7A}, {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00},
-    {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x10,0x28,0x44,0x00}, {0x7F,0x40,0x40,0x40,0x40},
-    {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
-    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46},
-    {0x46,0x49,0x49,0x49,0x31}, {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F},
-    {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F}, {0x63,0x14,0x08,0x14,0x63},
-    {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
-    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04},
-    {0x40,0x40,0x40,0x40,0x40}, {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78},
-    {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, {0x38,0x44,0x44,0x48,0x7F},
-    {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
-    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00},
-    {0x7F,0x10,0x28,0x44,0x00}, {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78},
-    {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, {0x7C,0x14,0x14,0x14,0x08},
-    {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
-    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C},
-    {0x3C,0x40,0x30,0x40,0x3C}, {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C},
-    {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, {0x00,0x00,0x7F,0x00,0x00},
-    {0x00,0x41,0x36,0x08,0x00}, {0x10,0x08,0x08,0x10,0x08},
-};
+// i2c_master_transmit takes milliseconds, not ticks. A full screen is about
+// 23 ms on the wire at 400 kHz.
+#define SSD1306_XFER_TIMEOUT_MS 200
+
+// The frame buffer in the controller's layout: page-major, one byte per
+// column, bit 0 at the top. frame[0] gives page 0 a byte in front for the
+// I2C control byte, so any run of pages goes out without copying.
+static uint8_t frame[1 + SSD1306_PAGES * SSD1306_COLUMNS];
+static uint8_t *const fb = &frame[1];
+// Pages changed since the last flush; dirty_first > dirty_last when none.
+static uint8_t dirty_first = SSD1306_PAGES;
+static uint8_t dirty_last = 0;
 
 static esp_err_t ssd1306_write(uint8_t control, const uint8_t *data, size_t len) {
     if (!ssd1306_mutex || !i2c_dev) {
@@ -60,20 +36,20 @@ static esp_err_t ssd1306_write(uint8_t control, const uint8_t *data, size_t len)
         return ESP_ERR_TIMEOUT;
     }
 
-    const size_t max_payload = 1 + SSD1306_WIDTH;
-    uint8_t buffer[1 + SSD1306_WIDTH] = {0};
+    const size_t max_payload = 1 + SSD1306_COLUMNS;
+    uint8_t buffer[1 + SSD1306_COLUMNS] = {0};
     buffer[0] = control;
 
     if (data && len) {
-        if (len > SSD1306_WIDTH) {
-            len = SSD1306_WIDTH;
+        if (len > SSD1306_COLUMNS) {
+            len = SSD1306_COLUMNS;
         }
         memcpy(&buffer[1], data, len);
     } else {
         len = 0;
     }
 
-    esp_err_t err = i2c_master_transmit(i2c_dev, buffer, len + 1, pdMS_TO_TICKS(200));
+    esp_err_t err = i2c_master_transmit(i2c_dev, buffer, len + 1, SSD1306_XFER_TIMEOUT_MS);
 
     xSemaphoreGive(ssd1306_mutex);
 
@@ -92,28 +68,155 @@ static esp_err_t ssd1306_send_commands(const uint8_t *commands, size_t len) {
     return ssd1306_write(0x00, commands, len);
 }
 
-static esp_err_t ssd1306_send_data(const uint8_t *data, size_t len) {
-    if (!data || len == 0) return ESP_OK;
-    return ssd1306_write(0x40, data, len);
+// Sends pages first..last of the frame buffer as a single I2C write. The
+// byte before the first page stands in for the control byte meanwhile.
+static esp_err_t ssd1306_send_pages(uint8_t first, uint8_t last) {
+    if (!ssd1306_mutex || !i2c_dev) {
+        return ESP_FAIL;
+    }
+
+    const uint8_t window[] = {0x21, 0, SSD1306_COLUMNS - 1, 0x22, first, last};
+    esp_err_t err = ssd1306_send_commands(window, sizeof(window));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (xSemaphoreTake(ssd1306_mutex, pdMS_TO_TICKS(200)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    uint8_t *burst = &fb[first * SSD1306_COLUMNS] - 1;
+    uint8_t saved = *burst;
+    *burst = 0x40;
+    err = i2c_master_transmit(i2c_dev, burst, 1 + (size_t)(last - first + 1) * SSD1306_COLUMNS,
+                              SSD1306_XFER_TIMEOUT_MS);
+    *burst = saved;
+    xSemaphoreGive(ssd1306_mutex);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "I2C transmit failed: %s", esp_err_to_name(err));
+    }
+    return err;
 }
 
-static void ssd1306_draw_char(uint8_t line, uint8_t column, char c) {
-    if (!ssd1306_initialized) return;
-    if (line >= SSD1306_PAGE_COUNT) return;
-    if (c < 32 || c > 126) c = ' ';
+static void mark_dirty(uint8_t first, uint8_t last) {
+    if (first < dirty_first) dirty_first = first;
+    if (last > dirty_last) dirty_last = last;
+}
 
-    uint8_t col = column * 6;
-    if (col > SSD1306_WIDTH - 6) return;
+static uint8_t clamp_scale(uint8_t scale) {
+    return scale < 1 ? 1 : scale > SSD1306_SCALE_MAX ? SSD1306_SCALE_MAX : scale;
+}
 
-    const uint8_t *glyph = font5x7[(uint8_t)c - 32];
-    uint8_t buffer[6];
-    memcpy(buffer, glyph, 5);
-    buffer[5] = 0x00;
+static const uint8_t *glyph_page(uint8_t scale, char c, uint8_t page) {
+    uint8_t code = (c < 32 || c > 126) ? 0 : (uint8_t)(c - SSD1306_GLYPH_FIRST);
+    switch (scale) {
+    case 3: return ssd1306_glyphs_3x[code][page];
+    case 2: return ssd1306_glyphs_2x[code][page];
+    default: return ssd1306_glyphs_1x[code][page];
+    }
+}
 
-    ssd1306_send_command(0xB0 + line);
-    ssd1306_send_command(0x00 | (col & 0x0F));
-    ssd1306_send_command(0x10 | ((col >> 4) & 0x0F));
-    ssd1306_send_data(buffer, sizeof(buffer));
+// Copies up to len characters of text into the frame buffer, one page row
+// of the whole string at a time. Characters that would not fit whole are
+// dropped. Returns the column after the last one drawn.
+static uint8_t blit(uint8_t page, uint8_t x, uint8_t scale, const char *text, size_t len) {
+    const uint8_t width = 6 * scale;
+    if (page + scale > SSD1306_PAGES || x >= SSD1306_COLUMNS) {
+        return x;
+    }
+    size_t fit = (SSD1306_COLUMNS - x) / width;
+    if (len > fit) {
+        len = fit;
+    }
+    for (uint8_t p = 0; p < scale; p++) {
+        uint8_t *dst = &fb[(page + p) * SSD1306_COLUMNS + x];
+        for (size_t i = 0; i < len; i++, dst += width) {
+            memcpy(dst, glyph_page(scale, text[i], p), width);
+        }
+    }
+    if (len) {
+        mark_dirty(page, page + scale - 1);
+    }
+    return x + len * width;
+}
+
+// Greedy word wrap over rows of scale pages; a word longer than a row is
+// split. Draws only when draw is set. Returns true when all of text fits.
+static bool layout(uint8_t page, uint8_t pages, uint8_t scale, const char *text, bool draw) {
+    const size_t per_row = SSD1306_COLUMNS / (6 * scale);
+    for (uint8_t row = 0; row < pages / scale; row++) {
+        while (*text == ' ') text++;
+        size_t len = strnlen(text, per_row + 1);
+        if (len == 0) {
+            return true;
+        }
+        if (len > per_row) {
+            len = per_row;
+            size_t space = per_row;
+            while (space > 0 && text[space] != ' ') space--;
+            if (space > 0) {
+                len = space;
+            }
+        }
+        if (draw) {
+            blit(page + row * scale, 0, scale, text, len);
+        }
+        text += len;
+    }
+    while (*text == ' ') text++;
+    return *text == '\0';
+}
+
+void ssd1306_fb_clear(void) {
+    memset(fb, 0, SSD1306_PAGES * SSD1306_COLUMNS);
+    mark_dirty(0, SSD1306_PAGES - 1);
+}
+
+void ssd1306_fb_clear_pages(uint8_t page, uint8_t pages) {
+    if (page >= SSD1306_PAGES || pages == 0) return;
+    if (pages > SSD1306_PAGES - page) pages = SSD1306_PAGES - page;
+    memset(&fb[page * SSD1306_COLUMNS], 0, (size_t)pages * SSD1306_COLUMNS);
+    mark_dirty(page, page + pages - 1);
+}
+
+uint8_t ssd1306_fb_text(uint8_t page, uint8_t x, uint8_t scale, const char *text) {
+    if (!text) return x;
+    return blit(page, x, clamp_scale(scale), text, strlen(text));
+}
+
+uint8_t ssd1306_fb_text_centered(uint8_t page, uint8_t scale, const char *text) {
+    if (!text) return 0;
+    scale = clamp_scale(scale);
+    uint16_t width = ssd1306_text_width(scale, text);
+    uint8_t x = width < SSD1306_COLUMNS ? (SSD1306_COLUMNS - width) / 2 : 0;
+    return blit(page, x, scale, text, strlen(text));
+}
+
+bool ssd1306_fb_text_wrapped(uint8_t page, uint8_t pages, uint8_t scale, const char *text) {
+    if (!text) return true;
+    return layout(page, pages, clamp_scale(scale), text, true);
+}
+
+bool ssd1306_text_fits(uint8_t pages, uint8_t scale, const char *text) {
+    if (!text) return true;
+    return layout(0, pages, clamp_scale(scale), text, false);
+}
+
+uint16_t ssd1306_text_width(uint8_t scale, const char *text) {
+    if (!text) return 0;
+    size_t width = strlen(text) * 6 * clamp_scale(scale);
+    return width > UINT16_MAX ? UINT16_MAX : (uint16_t)width;
+}
+
+esp_err_t ssd1306_flush(void) {
+    if (!ssd1306_initialized) return ESP_ERR_INVALID_STATE;
+    if (dirty_first > dirty_last) return ESP_OK;
+    esp_err_t err = ssd1306_send_pages(dirty_first, dirty_last);
+    if (err == ESP_OK) {
+        dirty_first = SSD1306_PAGES;
+        dirty_last = 0;
+    }
+    return err;
 }
 
 esp_err_t ssd1306_init(const ssd1306_config_t *config) {
@@ -122,7 +225,7 @@ esp_err_t ssd1306_init(const ssd1306_config_t *config) {
     }
 
     if (ssd1306_mutex == NULL) {
-        ssd1306_mutex = xSemaphoreCreateMutex();
+        ssd1306_mutex = xSemaphoreCreateMutexStatic(&ssd1306_mutex_buf);
         if (!ssd1306_mutex) {
             return ESP_ERR_NO_MEM;
         }
@@ -168,9 +271,10 @@ esp_err_t ssd1306_init(const ssd1306_config_t *config) {
     }
 
     ssd1306_initialized = true;
-    ssd1306_clear();
-    ssd1306_draw_text(0, 0, "RFID System");
-    ssd1306_draw_text(2, 0, "Booting...");
+    ssd1306_fb_clear();
+    ssd1306_fb_text(0, 0, 1, "RFID System");
+    ssd1306_fb_text(2, 0, 1, "Booting...");
+    ssd1306_flush();
     ESP_LOGI(TAG, "SSD1306 display initialized");
     return ESP_OK;
 }
@@ -189,42 +293,32 @@ void ssd1306_power_on(void) {
 
 void ssd1306_clear(void) {
     if (!ssd1306_initialized) return;
-
-    uint8_t zero_buffer[SSD1306_WIDTH];
-    memset(zero_buffer, 0x00, sizeof(zero_buffer));
-
-    for (uint8_t page = 0; page < SSD1306_PAGE_COUNT; page++) {
-        ssd1306_send_command(0xB0 + page);
-        ssd1306_send_command(0x00);
-        ssd1306_send_command(0x10);
-        ssd1306_send_data(zero_buffer, sizeof(zero_buffer));
-    }
+    ssd1306_fb_clear();
+    ssd1306_flush();
 }
 
 void ssd1306_draw_text(uint8_t line, uint8_t column, const char *text) {
     if (!ssd1306_initialized || !text) return;
-    uint8_t col = column;
-    while (*text && col < (SSD1306_WIDTH / 6)) {
-        ssd1306_draw_char(line, col, *text++);
-        col++;
-    }
+    ssd1306_fb_text(line, column * 6, 1, text);
+    ssd1306_flush();
 }
 
 void ssd1306_draw_line(uint8_t page, uint8_t column, const uint8_t *data, size_t len) {
     if (!ssd1306_initialized || !data || len == 0) return;
-    ssd1306_send_command(0xB0 + page);
-    ssd1306_send_command(0x00 | (column & 0x0F));
-    ssd1306_send_command(0x10 | ((column >> 4) & 0x0F));
-    ssd1306_send_data(data, len);
+    if (page >= SSD1306_PAGES || column >= SSD1306_COLUMNS) return;
+    if (len > (size_t)(SSD1306_COLUMNS - column)) len = SSD1306_COLUMNS - column;
+    memcpy(&fb[page * SSD1306_COLUMNS + column], data, len);
+    mark_dirty(page, page);
+    ssd1306_flush();
 }
 
 void ssd1306_show_scanned_uid(const char *uid) {
     if (!ssd1306_initialized || !uid) return;
 
-    ssd1306_clear();
-    ssd1306_draw_text(0, 0, "CARD SCANNED");
-    ssd1306_draw_text(2, 0, "UID:");
-    ssd1306_draw_text(3, 0, uid);
-    ssd1306_draw_text(5, 0, "Sent to gateway");
+    ssd1306_fb_clear();
+    ssd1306_fb_text(0, 0, 1, "CARD SCANNED");
+    ssd1306_fb_text(2, 0, 1, "UID:");
+    ssd1306_fb_text(3, 0, 1, uid);
+    ssd1306_fb_text(5, 0, 1, "Sent to gateway");
+    ssd1306_flush();
 }
-
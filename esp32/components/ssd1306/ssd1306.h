@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "esp_err.h"
 
@@ -8,6 +9,11 @@
 extern "C" {
 #endif
 
+#define SSD1306_COLUMNS 128
+#define SSD1306_PAGES 8
+// Glyphs are 6*scale columns by scale pages: 21, 10 or 7 characters a line.
+#define SSD1306_SCALE_MAX 3
+
 typedef struct {
     int i2c_port;
     int sda_io;
@@ -24,6 +30,22 @@ void ssd1306_draw_text(uint8_t line, uint8_t column, const char *text);
 void ssd1306_draw_line(uint8_t page, uint8_t column, const uint8_t *data, size_t len);
 void ssd1306_show_scanned_uid(const char *uid);
 
+// Frame buffer drawing. Nothing reaches the display until ssd1306_flush(),
+// which sends the changed pages as one I2C write; build a whole screen and
+// flush once. Callers serialize use of the frame buffer.
+void ssd1306_fb_clear(void);
+void ssd1306_fb_clear_pages(uint8_t page, uint8_t pages);
+// Draws text at column x with its top on page; characters that do not fit
+// whole are dropped. Returns the column after the text.
+uint8_t ssd1306_fb_text(uint8_t page, uint8_t x, uint8_t scale, const char *text);
+uint8_t ssd1306_fb_text_centered(uint8_t page, uint8_t scale, const char *text);
+// Word-wraps text over rows of scale pages within pages; returns false if
+// some of it did not fit (what fits is still drawn).
+bool ssd1306_fb_text_wrapped(uint8_t page, uint8_t pages, uint8_t scale, const char *text);
+bool ssd1306_text_fits(uint8_t pages, uint8_t scale, const char *text);
+uint16_t ssd1306_text_width(uint8_t scale, const char *text);
+esp_err_t ssd1306_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
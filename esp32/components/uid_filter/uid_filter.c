@@ -0,0 +1,45 @@
+#include "uid_filter.h"
+
+#include <string.h>
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t fnv1a64(const char *s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+bool uid_filter_parse(uid_filter_t *f, const uint8_t *buf, size_t len) {
+    if (len < UID_FILTER_HEADER_LEN || memcmp(buf, "UIDF", 4) != 0 || buf[4] != UID_FILTER_VERSION) {
+        return false;
+    }
+    uint8_t k = buf[5];
+    uint32_t m_bits = read_le32(buf + 8);
+    if (k == 0 || m_bits == 0 || m_bits % 8 != 0 || len - UID_FILTER_HEADER_LEN != m_bits / 8) {
+        return false;
+    }
+    f->k = k;
+    f->m_bits = m_bits;
+    f->n = read_le32(buf + 12);
+    f->bits = buf + UID_FILTER_HEADER_LEN;
+    return true;
+}
+
+bool uid_filter_maybe_contains(const uid_filter_t *f, const char *uid) {
+    uint64_t h = fnv1a64(uid);
+    uint64_t h1 = h & 0xFFFFFFFFu;
+    uint64_t h2 = (h >> 32) | 1;
+    for (uint32_t j = 0; j < f->k; j++) {
+        uint32_t i = (uint32_t)((h1 + j * h2) % f->m_bits);
+        if (!(f->bits[i >> 3] & (1u << (i & 7)))) {
+            return false;
+        }
+    }
+    return true;
+}
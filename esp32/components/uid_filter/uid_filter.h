@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Registered-UID Bloom filter as served by the admin API's GET /rfid/filter
+// (see build_uid_filter in admin/main.py for the layout). Plain C with no
+// ESP-IDF dependencies so host/uid_filter_probe.c can check it against the
+// Python builder.
+
+#define UID_FILTER_HEADER_LEN 16
+#define UID_FILTER_VERSION    1
+
+typedef struct {
+    uint8_t k;            // probes per UID
+    uint32_t m_bits;      // filter size in bits
+    uint32_t n;           // UIDs in the filter
+    const uint8_t *bits;  // m_bits / 8 bytes, owned by the caller's buffer
+} uid_filter_t;
+
+// Validate a downloaded filter and point f at it; buf must outlive f.
+bool uid_filter_parse(uid_filter_t *f, const uint8_t *buf, size_t len);
+
+// false: the UID is certainly not registered. true: it probably is.
+bool uid_filter_maybe_contains(const uid_filter_t *f, const char *uid);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,361 @@
+#include "idf_shim.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+int64_t shim_now_us = 0;
+int shim_http_connects = 0;
+void (*shim_http_server)(const char *, const char *, const char *, const char *, size_t,
+                         shim_http_response_t *) = NULL;
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+const char *esp_err_to_name(esp_err_t err) {
+    switch (err) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        default: return "ESP_FAIL";
+    }
+}
+
+void shim_log(char level, const char *tag, const char *fmt, ...) {
+    static int max_rank = -1;
+    if (max_rank < 0) {
+        const char *env = getenv("SHIM_LOG"); // E (default), W, I or D
+        max_rank = env && env[0] && strchr("EWID", env[0]) ? (int)(strchr("EWID", env[0]) - "EWID") : 0;
+    }
+    if (strchr("EWID", level) - "EWID" > max_rank) {
+        return;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%c (%lld) %s: ", level, (long long)(shim_now_us / 1000), tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+// FreeRTOS: tasks are never started; the soak calls task bodies' steps itself.
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                               UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb) {
+    tcb->name = name;
+    tcb->stack_size = stack_size;
+    return tcb;
+}
+void vTaskDelay(TickType_t ticks) { shim_now_us += (int64_t)ticks * 1000000 / configTICK_RATE_HZ; }
+void vTaskDelete(TaskHandle_t task) {}
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return task->stack_size; }
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *q) {
+    *q = (StaticQueue_t){ .storage = storage, .item_size = item_size, .length = length };
+    return q;
+}
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    if (q->count == q->length) {
+        return pdFALSE;
+    }
+    memcpy(q->storage + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+    q->count++;
+    return pdTRUE;
+}
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    if (q->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, q->storage + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return pdTRUE;
+}
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf) { return buf; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return pdTRUE; }
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buf) { buf->bits = 0; return buf; }
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) { return g->bits |= bits; }
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+    EventBits_t old = g->bits;
+    g->bits &= ~bits;
+    return old;
+}
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g) { return g->bits; }
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear, BaseType_t all,
+                                TickType_t wait) {
+    return g->bits;
+}
+
+uint32_t esp_random(void) {
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+int64_t esp_timer_get_time(void) { return shim_now_us; }
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) { *out = NULL; return ESP_OK; }
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us) { return ESP_OK; }
+esp_err_t esp_timer_stop(esp_timer_handle_t t) { return ESP_OK; }
+size_t heap_caps_get_free_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return 0; }
+
+esp_err_t esp_event_loop_create_default(void) { return ESP_OK; }
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t fn, void *arg) { return ESP_OK; }
+esp_err_t esp_netif_init(void) { return ESP_OK; }
+void *esp_netif_create_default_wifi_sta(void) { return NULL; }
+esp_err_t esp_wifi_init(const wifi_init_config_t *cfg) { return ESP_OK; }
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { return ESP_OK; }
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *cfg) { return ESP_OK; }
+esp_err_t esp_wifi_start(void) { return ESP_OK; }
+esp_err_t esp_wifi_connect(void) { return ESP_OK; }
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap) { return ESP_FAIL; }
+esp_err_t esp_netif_sntp_init(const esp_sntp_config_t *cfg) { return ESP_OK; }
+
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+esp_err_t nvs_flash_erase(void) { return ESP_OK; }
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out) {
+    *out = 1;
+    return mode == NVS_READONLY ? ESP_ERR_NVS_NOT_FOUND : ESP_OK;
+}
+void nvs_close(nvs_handle_t h) {}
+esp_err_t nvs_commit(nvs_handle_t h) { return ESP_OK; }
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len) { return ESP_ERR_NVS_NOT_FOUND; }
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *value, size_t len) { return ESP_OK; }
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len) { return ESP_ERR_NVS_NOT_FOUND; }
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *value) { return ESP_OK; }
+
+// u32 values are kept for the life of the process, like an NVS that was
+// empty at boot.
+#define SHIM_NVS_U32_SLOTS 8
+static struct { char key[16]; uint32_t value; } shim_nvs_u32[SHIM_NVS_U32_SLOTS];
+static int shim_nvs_u32_count;
+
+esp_err_t nvs_get_u32(nvs_handle_t h, const char *key, uint32_t *out) {
+    for (int i = 0; i < shim_nvs_u32_count; i++) {
+        if (strcmp(shim_nvs_u32[i].key, key) == 0) {
+            *out = shim_nvs_u32[i].value;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+esp_err_t nvs_set_u32(nvs_handle_t h, const char *key, uint32_t value) {
+    for (int i = 0; i < shim_nvs_u32_count; i++) {
+        if (strcmp(shim_nvs_u32[i].key, key) == 0) {
+            shim_nvs_u32[i].value = value;
+            return ESP_OK;
+        }
+    }
+    if (shim_nvs_u32_count == SHIM_NVS_U32_SLOTS) {
+        return ESP_FAIL;
+    }
+    snprintf(shim_nvs_u32[shim_nvs_u32_count].key, sizeof(shim_nvs_u32[0].key), "%s", key);
+    shim_nvs_u32[shim_nvs_u32_count++].value = value;
+    return ESP_OK;
+}
+
+// I2C: the bus and device are placeholders; transmits always succeed.
+void (*shim_i2c_transmit)(const uint8_t *data, size_t len);
+static struct shim_i2c_bus { int unused; } shim_i2c_bus;
+static struct shim_i2c_dev { int unused; } shim_i2c_dev;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg, i2c_master_bus_handle_t *out) {
+    *out = &shim_i2c_bus;
+    return ESP_OK;
+}
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *cfg,
+                                    i2c_master_dev_handle_t *out) {
+    *out = &shim_i2c_dev;
+    return ESP_OK;
+}
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms) {
+    if (shim_i2c_transmit) {
+        shim_i2c_transmit(data, len);
+    }
+    return ESP_OK;
+}
+
+// esp_http_client. Allocation sites follow the real client: the handle and
+// its rx/tx buffers at init, a realloc per URL part on set_url and per value
+// on set_header, and the socket/TLS state per connection.
+#define SHIM_HTTP_BUFFER_SIZE   512
+#define SHIM_HTTP_CONN_BYTES    4096
+
+typedef struct shim_header {
+    char *key;
+    char *value;
+    struct shim_header *next;
+} shim_header_t;
+
+struct shim_http_client {
+    char *host;
+    char *path;
+    shim_header_t *headers;
+    char *rx_buf;
+    char *tx_buf;
+    void *conn;
+    const char *post_data;
+    int post_len;
+    esp_http_client_method_t method;
+    http_event_handle_cb handler;
+    void *user_data;
+    int status;
+};
+
+static void assign_string(char **dst, const char *src, size_t len) {
+    *dst = *dst ? realloc(*dst, len + 1) : malloc(len + 1);
+    memcpy(*dst, src, len);
+    (*dst)[len] = '\0';
+}
+
+static void emit(esp_http_client_handle_t c, esp_http_client_event_id_t id, void *data, int len,
+                 char *key, char *value) {
+    if (c->handler) {
+        esp_http_client_event_t evt = {
+            .event_id = id, .client = c, .data = data, .data_len = len,
+            .user_data = c->user_data, .header_key = key, .header_value = value,
+        };
+        c->handler(&evt);
+    }
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *cfg) {
+    esp_http_client_handle_t c = calloc(1, sizeof(*c));
+    c->rx_buf = malloc(SHIM_HTTP_BUFFER_SIZE);
+    c->tx_buf = malloc(SHIM_HTTP_BUFFER_SIZE);
+    c->method = cfg->method;
+    c->handler = cfg->event_handler;
+    c->user_data = cfg->user_data;
+    esp_http_client_set_url(c, cfg->url);
+    return c;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t c) {
+    if (c->conn) {
+        free(c->conn);
+        c->conn = NULL;
+        emit(c, HTTP_EVENT_DISCONNECTED, NULL, 0, NULL, NULL);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t c) {
+    esp_http_client_close(c);
+    while (c->headers) {
+        shim_header_t *h = c->headers;
+        c->headers = h->next;
+        free(h->key);
+        free(h->value);
+        free(h);
+    }
+    free(c->host);
+    free(c->path);
+    free(c->rx_buf);
+    free(c->tx_buf);
+    free(c);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t c, const char *url) {
+    const char *host = strstr(url, "://");
+    host = host ? host + 3 : url;
+    const char *path = strchr(host, '/');
+    size_t host_len = path ? (size_t)(path - host) : strlen(host);
+    if (c->host && (strlen(c->host) != host_len || strncmp(c->host, host, host_len) != 0)) {
+        esp_http_client_close(c);
+    }
+    assign_string(&c->host, host, host_len);
+    assign_string(&c->path, path ? path : "/", path ? strlen(path) : 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t c, const char *key, const char *value) {
+    shim_header_t **link = &c->headers;
+    while (*link && strcasecmp((*link)->key, key) != 0) {
+        link = &(*link)->next;
+    }
+    if (!value) {
+        if (*link) {
+            shim_header_t *h = *link;
+            *link = h->next;
+            free(h->key);
+            free(h->value);
+            free(h);
+        }
+        return ESP_OK;
+    }
+    if (!*link) {
+        *link = calloc(1, sizeof(shim_header_t));
+        assign_string(&(*link)->key, key, strlen(key));
+    }
+    assign_string(&(*link)->value, value, strlen(value));
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t c, esp_http_client_method_t method) {
+    c->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t c, const char *data, int len) {
+    c->post_data = data;
+    c->post_len = data ? len : 0;
+    if (!data) {
+        return esp_http_client_set_header(c, "Content-Type", NULL);
+    }
+    for (shim_header_t *h = c->headers; h; h = h->next) {
+        if (strcasecmp(h->key, "Content-Type") == 0) {
+            return ESP_OK;
+        }
+    }
+    return esp_http_client_set_header(c, "Content-Type", "application/x-www-form-urlencoded");
+}
+
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t c, void *data) {
+    c->user_data = data;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t c) {
+    if (!c->conn) {
+        c->conn = malloc(SHIM_HTTP_CONN_BYTES);
+        shim_http_connects++;
+        emit(c, HTTP_EVENT_ON_CONNECTED, NULL, 0, NULL, NULL);
+    }
+    // Request line and headers go out through the fixed tx buffer.
+    char url[256];
+    snprintf(url, sizeof(url), "%s%s", c->host, c->path);
+    size_t off = 0;
+    for (shim_header_t *h = c->headers; h && off < SHIM_HTTP_BUFFER_SIZE; h = h->next) {
+        off += snprintf(c->tx_buf + off, SHIM_HTTP_BUFFER_SIZE - off, "%s: %s\n", h->key, h->value);
+    }
+    c->tx_buf[off < SHIM_HTTP_BUFFER_SIZE ? off : SHIM_HTTP_BUFFER_SIZE - 1] = '\0';
+
+    shim_http_response_t resp = { .status = 404 };
+    if (shim_http_server) {
+        shim_http_server(c->method == HTTP_METHOD_POST ? "POST" : "GET", url, c->tx_buf,
+                         c->post_data, (size_t)c->post_len, &resp);
+    }
+    c->status = resp.status;
+    if (resp.etag[0]) {
+        emit(c, HTTP_EVENT_ON_HEADER, NULL, 0, "ETag", resp.etag);
+    }
+    if (resp.retry_after_s > 0) {
+        char value[12];
+        snprintf(value, sizeof(value), "%d", resp.retry_after_s);
+        emit(c, HTTP_EVENT_ON_HEADER, NULL, 0, "Retry-After", value);
+    }
+    // The body arrives through the rx buffer in buffer-sized pieces.
+    for (size_t sent = 0; sent < resp.body_len;) {
+        size_t n = resp.body_len - sent < SHIM_HTTP_BUFFER_SIZE ? resp.body_len - sent : SHIM_HTTP_BUFFER_SIZE;
+        memcpy(c->rx_buf, (const uint8_t *)resp.body + sent, n);
+        emit(c, HTTP_EVENT_ON_DATA, c->rx_buf, (int)n, NULL, NULL);
+        sent += n;
+    }
+    emit(c, HTTP_EVENT_ON_FINISH, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t c) { return c->status; }
@@ -0,0 +1,233 @@
+#pragma once
+
+// Just enough of the ESP-IDF and FreeRTOS API to compile main/main.c on the
+// host for host/scan_soak.c, and components/ssd1306 for host/oled_render_bench.c. Single-threaded: locks are no-ops, queues are
+// ring buffers, and the clock only moves when the soak advances it. The HTTP
+// client allocates where the real one does (client, buffers, headers, URL
+// parts, one block per open connection) so allocation counts are meaningful.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef int esp_err_t;
+#define ESP_OK                          0
+#define ESP_FAIL                        -1
+#define ESP_ERR_NO_MEM                  0x101
+#define ESP_ERR_INVALID_ARG             0x102
+#define ESP_ERR_INVALID_STATE           0x103
+#define ESP_ERR_NOT_FOUND               0x105
+#define ESP_ERR_TIMEOUT                 0x107
+#define ESP_ERR_NVS_NOT_FOUND           0x1102
+#define ESP_ERR_NVS_NO_FREE_PAGES       0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   0x1110
+#define ESP_ERROR_CHECK(x)              ((void)(x))
+const char *esp_err_to_name(esp_err_t err);
+
+// Logging goes to stderr, errors only unless SHIM_LOG=W/I/D.
+void shim_log(char level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+#define ESP_LOGE(tag, fmt, ...) shim_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) shim_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) shim_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) shim_log('D', tag, fmt, ##__VA_ARGS__)
+
+// FreeRTOS
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint8_t StackType_t;
+typedef uint32_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct shim_task *TaskHandle_t;
+typedef struct shim_queue *QueueHandle_t;
+typedef struct shim_queue *SemaphoreHandle_t;
+typedef struct shim_event_group *EventGroupHandle_t;
+typedef struct shim_task { const char *name; uint32_t stack_size; } StaticTask_t;
+typedef struct shim_queue {
+    uint8_t *storage;
+    UBaseType_t item_size;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+} StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+typedef struct shim_event_group { EventBits_t bits; } StaticEventGroup_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define portMAX_DELAY           0xffffffffu
+#define configTICK_RATE_HZ      100
+#define pdMS_TO_TICKS(ms)       ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                               UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *q);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buf);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t wait);
+
+// esp_system / esp_timer / heap
+uint32_t esp_random(void);
+extern int64_t shim_now_us;
+int64_t esp_timer_get_time(void);
+typedef struct shim_timer *esp_timer_handle_t;
+typedef struct { void (*callback)(void *); void *arg; const char *name; } esp_timer_create_args_t;
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t t);
+#define MALLOC_CAP_8BIT (1 << 2)
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+// Events, netif, WiFi, SNTP
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+extern esp_event_base_t const WIFI_EVENT;
+extern esp_event_base_t const IP_EVENT;
+#define ESP_EVENT_ANY_ID                -1
+#define WIFI_EVENT_STA_START            2
+#define WIFI_EVENT_STA_DISCONNECTED     5
+#define IP_EVENT_STA_GOT_IP             0
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t fn, void *arg);
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { struct { esp_ip4_addr_t ip; } ip_info; } ip_event_got_ip_t;
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(a) (int)((a)->addr & 0xff), (int)(((a)->addr >> 8) & 0xff), \
+                  (int)(((a)->addr >> 16) & 0xff), (int)(((a)->addr >> 24) & 0xff)
+esp_err_t esp_netif_init(void);
+void *esp_netif_create_default_wifi_sta(void);
+typedef struct { int reserved; } wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+typedef enum { WIFI_MODE_STA = 1 } wifi_mode_t;
+typedef enum { WIFI_IF_STA = 0 } wifi_interface_t;
+typedef enum { WIFI_FAST_SCAN = 0, WIFI_ALL_CHANNEL_SCAN } wifi_scan_method_t;
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    wifi_scan_method_t scan_method;
+    bool bssid_set;
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_sta_config_t;
+typedef union { wifi_sta_config_t sta; } wifi_config_t;
+typedef struct { uint8_t bssid[6]; uint8_t primary; } wifi_ap_record_t;
+typedef struct { uint8_t reason; } wifi_event_sta_disconnected_t;
+esp_err_t esp_wifi_init(const wifi_init_config_t *cfg);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *cfg);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap);
+typedef struct { const char *server; } esp_sntp_config_t;
+#define ESP_NETIF_SNTP_DEFAULT_CONFIG(s) { .server = (s) }
+esp_err_t esp_netif_sntp_init(const esp_sntp_config_t *cfg);
+
+// NVS: always empty, writes are accepted and discarded.
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out);
+void nvs_close(nvs_handle_t h);
+esp_err_t nvs_commit(nvs_handle_t h);
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len);
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *value, size_t len);
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len);
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *value);
+esp_err_t nvs_get_u32(nvs_handle_t h, const char *key, uint32_t *out);
+esp_err_t nvs_set_u32(nvs_handle_t h, const char *key, uint32_t value);
+
+// SPI types used by rc522.h
+typedef int spi_host_device_t;
+typedef struct shim_spi_device *spi_device_handle_t;
+#define SPI2_HOST 1
+
+// I2C master, for components/ssd1306. Every transmit is passed to
+// shim_i2c_transmit when set.
+typedef struct shim_i2c_bus *i2c_master_bus_handle_t;
+typedef struct shim_i2c_dev *i2c_master_dev_handle_t;
+typedef enum { I2C_CLK_SRC_DEFAULT = 0 } i2c_clock_source_t;
+typedef struct {
+    int i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    i2c_clock_source_t clk_source;
+    struct { uint32_t enable_internal_pullup : 1; } flags;
+} i2c_master_bus_config_t;
+typedef struct {
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+} i2c_device_config_t;
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg, i2c_master_bus_handle_t *out);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *cfg,
+                                    i2c_master_dev_handle_t *out);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms);
+extern void (*shim_i2c_transmit)(const uint8_t *data, size_t len);
+
+// esp_http_client
+typedef struct shim_http_client *esp_http_client_handle_t;
+typedef enum { HTTP_METHOD_GET = 0, HTTP_METHOD_POST } esp_http_client_method_t;
+typedef enum {
+    HTTP_EVENT_ERROR = 0,
+    HTTP_EVENT_ON_CONNECTED,
+    HTTP_EVENT_HEADERS_SENT,
+    HTTP_EVENT_ON_HEADER,
+    HTTP_EVENT_ON_DATA,
+    HTTP_EVENT_ON_FINISH,
+    HTTP_EVENT_DISCONNECTED,
+} esp_http_client_event_id_t;
+typedef struct {
+    esp_http_client_event_id_t event_id;
+    esp_http_client_handle_t client;
+    void *data;
+    int data_len;
+    void *user_data;
+    char *header_key;
+    char *header_value;
+} esp_http_client_event_t;
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t *evt);
+typedef struct {
+    const char *url;
+    esp_http_client_method_t method;
+    int timeout_ms;
+    http_event_handle_cb event_handler;
+    void *user_data;
+    bool keep_alive_enable;
+    bool save_client_session;
+} esp_http_client_config_t;
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *cfg);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t c);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t c, const char *url);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t c, esp_http_client_method_t method);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t c, const char *key, const char *value);
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t c, const char *data, int len);
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t c, void *data);
+esp_err_t esp_http_client_perform(esp_http_client_handle_t c);
+esp_err_t esp_http_client_close(esp_http_client_handle_t c);
+int esp_http_client_get_status_code(esp_http_client_handle_t c);
+
+// The soak plays the server: fill status, ETag, Retry-After and body for one
+// request.
+typedef struct {
+    int status;
+    char etag[48];
+    int retry_after_s; // sent as a Retry-After header when > 0
+    const void *body;
+    size_t body_len;
+} shim_http_response_t;
+extern void (*shim_http_server)(const char *method, const char *url, const char *headers,
+                                const char *body, size_t body_len, shim_http_response_t *resp);
+extern int shim_http_connects; // connections opened (TLS handshakes on the device)
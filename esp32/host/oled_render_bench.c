@@ -0,0 +1,236 @@
+// Render and transfer cost of one oled_show_event screen.
+//
+// Builds components/ssd1306 against host/idf_shim and plays the event screen
+// for short, medium and long names two ways:
+//
+//   per-char  the previous driver: clear the display page by page, then for
+//             every character set page and column (three 2-byte command
+//             writes) and send its 6 columns; name cut at 21 characters
+//   frame     ssd1306_fb_* into the frame buffer (3x ENTRY/EXIT, name at 2x
+//             or 1x word-wrapped, greeting), then one ssd1306_flush()
+//
+// For each it reports I2C transactions and bytes, time on the wire at the
+// given SCL rate (9 clocks per byte plus start/stop), the same with a fixed
+// driver cost per i2c_master_transmit, and host CPU time to render. A model
+// of the controller's RAM decodes the command stream; -v prints the
+// resulting screen.
+//
+// Build and run from esp32/:
+//   python3 components/ssd1306/gen_glyphs.py /tmp/ssd1306_glyphs.h
+//   gcc -O2 -Ihost/idf_shim -I/tmp -Icomponents/ssd1306 -o /tmp/oled_render_bench
+//       host/oled_render_bench.c components/ssd1306/ssd1306.c host/idf_shim/idf_shim.c
+//   /tmp/oled_render_bench [scl_khz] [txn_overhead_us] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "ssd1306_glyphs.h"
+
+#define RENDER_RUNS 20000
+
+// Bus accounting and the controller model ---------------------------------
+
+static unsigned long txns;
+static unsigned long bytes;
+static uint8_t gddram[SSD1306_PAGES][SSD1306_COLUMNS];
+static struct {
+    uint8_t page, col;
+    uint8_t col_start, col_end, page_start, page_end;
+    bool horizontal;
+} ram;
+
+static int command_args(uint8_t cmd) {
+    switch (cmd) {
+    case 0x20: case 0x81: case 0xA8: case 0xD3: case 0xD5:
+    case 0xD9: case 0xDA: case 0xDB: case 0x8D:
+        return 1;
+    case 0x21: case 0x22:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+static void model_transmit(const uint8_t *data, size_t len) {
+    txns++;
+    bytes += len;
+    if (len == 0) return;
+    if (data[0] == 0x00) {
+        for (size_t i = 1; i < len; i++) {
+            uint8_t cmd = data[i];
+            int args = command_args(cmd);
+            if (i + args >= len + (args ? 0 : 1)) break;
+            if (cmd == 0x20) {
+                ram.horizontal = data[i + 1] == 0x00;
+            } else if (cmd == 0x21) {
+                ram.col_start = ram.col = data[i + 1];
+                ram.col_end = data[i + 2];
+            } else if (cmd == 0x22) {
+                ram.page_start = ram.page = data[i + 1];
+                ram.page_end = data[i + 2];
+            } else if (cmd >= 0xB0 && cmd <= 0xB7) {
+                ram.page = cmd - 0xB0;
+            } else if (cmd <= 0x0F) {
+                ram.col = (ram.col & 0xF0) | cmd;
+            } else if (cmd >= 0x10 && cmd <= 0x1F) {
+                ram.col = (uint8_t)((ram.col & 0x0F) | ((cmd & 0x0F) << 4));
+            }
+            i += args;
+        }
+        return;
+    }
+    for (size_t i = 1; i < len; i++) {
+        gddram[ram.page % SSD1306_PAGES][ram.col % SSD1306_COLUMNS] = data[i];
+        if (!ram.horizontal) {
+            ram.col++;
+        } else if (ram.col++ == ram.col_end) {
+            ram.col = ram.col_start;
+            ram.page = ram.page == ram.page_end ? ram.page_start : ram.page + 1;
+        }
+    }
+}
+
+static void print_screen(void) {
+    for (int y = 0; y < SSD1306_PAGES * 8; y++) {
+        putchar('|');
+        for (int x = 0; x < SSD1306_COLUMNS; x++) {
+            putchar(gddram[y / 8][x] >> (y % 8) & 1 ? '#' : ' ');
+        }
+        puts("|");
+    }
+}
+
+// The previous per-character driver ----------------------------------------
+
+static void legacy_write(uint8_t control, const uint8_t *data, size_t len) {
+    uint8_t buffer[1 + SSD1306_COLUMNS];
+    buffer[0] = control;
+    memcpy(&buffer[1], data, len);
+    i2c_master_transmit(NULL, buffer, len + 1, 200);
+}
+
+static void legacy_command(uint8_t cmd) {
+    legacy_write(0x00, &cmd, 1);
+}
+
+static void legacy_clear(void) {
+    uint8_t zero[SSD1306_COLUMNS] = {0};
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        legacy_command(0xB0 + page);
+        legacy_command(0x00);
+        legacy_command(0x10);
+        legacy_write(0x40, zero, sizeof(zero));
+    }
+}
+
+static void legacy_draw_text(uint8_t line, const char *text) {
+    for (uint8_t column = 0; *text && column < SSD1306_COLUMNS / 6; column++) {
+        char c = *text++;
+        if (c < 32 || c > 126) c = ' ';
+        uint8_t col = column * 6;
+        uint8_t buffer[6];
+        memcpy(buffer, ssd1306_glyphs_1x[c - SSD1306_GLYPH_FIRST][0], 5);
+        buffer[5] = 0x00;
+        legacy_command(0xB0 + line);
+        legacy_command(0x00 | (col & 0x0F));
+        legacy_command(0x10 | ((col >> 4) & 0x0F));
+        legacy_write(0x40, buffer, sizeof(buffer));
+    }
+}
+
+static void legacy_show_event(const char *name, bool is_entry) {
+    char line1[22];
+    snprintf(line1, sizeof(line1), "%s: %s", is_entry ? "ENTRY" : "EXIT", name);
+    legacy_clear();
+    legacy_draw_text(0, line1);
+    legacy_draw_text(2, is_entry ? "Welcome :D" : "Bye Bye :(");
+}
+
+// The frame buffer path, as oled_show_event in main.c -----------------------
+
+static void frame_render_event(const char *name, bool is_entry) {
+    ssd1306_fb_clear();
+    ssd1306_fb_text_centered(0, 3, is_entry ? "ENTRY" : "EXIT");
+    ssd1306_fb_text_wrapped(3, 4, ssd1306_text_fits(4, 2, name) ? 2 : 1, name);
+    ssd1306_fb_text_centered(7, 1, is_entry ? "Welcome :D" : "Bye Bye :(");
+}
+
+static void frame_show_event(const char *name, bool is_entry) {
+    frame_render_event(name, is_entry);
+    ssd1306_flush();
+}
+
+// -------------------------------------------------------------------------
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void report(const char *path, const char *name, double scl_khz, double txn_us, double render_us) {
+    // START + address byte + payload, 9 clocks a byte, plus about 2 for STOP.
+    double wire_us = ((bytes + txns) * 9.0 + txns * 2.0) * 1000.0 / scl_khz;
+    printf("  %-9s %-36s %5lu txns %6lu B  wire %6.2f ms  +driver %6.2f ms  render %6.2f us\n",
+           path, name, txns, bytes, wire_us / 1000, (wire_us + txns * txn_us) / 1000, render_us);
+}
+
+int main(int argc, char **argv) {
+    double scl_khz = 400, txn_us = 40;
+    bool verbose = false;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (positional++ == 0) {
+            scl_khz = atof(argv[i]);
+        } else {
+            txn_us = atof(argv[i]);
+        }
+    }
+
+    ssd1306_config_t cfg = {.i2c_address = 0x3C, .clk_speed_hz = (uint32_t)(scl_khz * 1000)};
+    shim_i2c_transmit = model_transmit;
+    if (ssd1306_init(&cfg) != ESP_OK) {
+        fprintf(stderr, "ssd1306_init failed\n");
+        return 1;
+    }
+
+    static const char *names[] = {
+        "Asha Rao",
+        "Priyanka Chaturvedi",
+        "Venkata Subramanian Raghavan Iyer",
+    };
+    printf("oled_show_event per screen, SCL %.0f kHz, %.0f us driver cost per transmit\n", scl_khz, txn_us);
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); n++) {
+        const char *name = names[n];
+
+        // Both paths render with the bus hooked to a no-op so the timing is
+        // the CPU side only; the per-char path interleaves the two, so its
+        // render time includes building every small write.
+        shim_i2c_transmit = NULL;
+        double t0 = now_us();
+        for (int r = 0; r < RENDER_RUNS; r++) legacy_show_event(name, r & 1);
+        double legacy_render = (now_us() - t0) / RENDER_RUNS;
+        t0 = now_us();
+        for (int r = 0; r < RENDER_RUNS; r++) frame_render_event(name, r & 1);
+        double frame_render = (now_us() - t0) / RENDER_RUNS;
+
+        shim_i2c_transmit = model_transmit;
+        txns = bytes = 0;
+        legacy_show_event(name, true);
+        report("per-char", name, scl_khz, txn_us, legacy_render);
+        if (verbose) print_screen();
+
+        ssd1306_fb_clear();
+        ssd1306_flush();
+        txns = bytes = 0;
+        frame_show_event(name, true);
+        report("frame", name, scl_khz, txn_us, frame_render);
+        if (verbose) print_screen();
+    }
+    return 0;
+}
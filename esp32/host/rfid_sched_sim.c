@@ -0,0 +1,331 @@
+// Host-side simulation of RFID polling policies over one library day.
+//
+// Compares the original fixed loop (poll every 125 ms, antenna always on,
+// 1000 ms pause after each read) with components/rfid_sched, and reports
+// detection latency against radio-on time. A second table puts 1-4 readers
+// on one SPI bus, served round-robin as in rfid_reader_task, each with its
+// own stream of taps, and reports per-reader latency as readers are added.
+//
+// Build and run from esp32/:
+//   gcc -O2 -Icomponents/rfid_sched -o /tmp/rfid_sched_sim
+//       host/rfid_sched_sim.c components/rfid_sched/rfid_sched.c -lm
+//   /tmp/rfid_sched_sim [days] [seed]
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rfid_sched.h"
+
+#define DAY_MS (24LL * 3600 * 1000)
+
+// RC522 timings: a poll with no card runs until the 15 ms receive timeout
+// configured in rc522_configure; a successful REQA + anticollision + HLTA
+// takes a few ms; the PCD needs a few ms after the antenna comes on before
+// a card is powered.
+#define POLL_EMPTY_MS      15
+#define POLL_READ_MS       6
+#define REMOVAL_CHECK_COST 3
+#define ANTENNA_SETTLE_MS  5
+
+// Taps per hour for a typical day, indexed by local hour.
+static const double TAPS_PER_HOUR[24] = {
+    0.2, 0.1, 0.1, 0.1, 0.1, 0.2, 1, 20,
+    120, 110, 80, 80, 150, 140, 100, 100,
+    90, 60, 40, 30, 20, 10, 2, 0.5,
+};
+
+// Students hold the card until the display reacts, then pull it away after
+// `react` ms; if nothing happens they give up after GIVE_UP_MS.
+#define GIVE_UP_MS 3000
+
+typedef struct {
+    int64_t arrive;
+    int64_t leave;
+    int64_t react;
+} tap_t;
+
+typedef struct {
+    const char *name;
+    double *latencies;
+    size_t detected;
+    size_t missed;
+    uint64_t radio_on_ms;
+    uint64_t polls;
+    int64_t span_ms;
+} result_t;
+
+static uint64_t rng_state;
+
+static double rng_uniform(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 2685821657736338717ULL) >> 11) / (double)(1ULL << 53);
+}
+
+static size_t generate_taps(tap_t *taps, size_t max, int days) {
+    size_t n = 0;
+    int64_t t = 0;
+    int64_t end = DAY_MS * days;
+    while (t < end && n < max) {
+        int hour = (int)((t / 3600000) % 24);
+        double rate_per_ms = TAPS_PER_HOUR[hour] / 3600000.0;
+        double gap = -log(1.0 - rng_uniform()) / rate_per_ms;
+        if (gap > 3600000.0) {
+            // Skip ahead to the next hour rather than carrying a tiny night rate forward.
+            t = (t / 3600000 + 1) * 3600000;
+            continue;
+        }
+        t += (int64_t)gap;
+        // A third of arrivals are the head of a queue at the gate.
+        int group = rng_uniform() < 0.3 ? 2 + (int)(rng_uniform() * 4) : 1;
+        for (int g = 0; g < group && n < max; g++) {
+            taps[n].arrive = t;
+            taps[n].leave = t + GIVE_UP_MS;
+            taps[n].react = 200 + (int64_t)(rng_uniform() * 600.0);
+            // The next student in the queue steps up shortly after.
+            t += 1000 + (int64_t)(rng_uniform() * 1500.0);
+            n++;
+        }
+    }
+    return n;
+}
+
+static bool card_in_field(const tap_t *tap, int64_t t) {
+    return tap->arrive <= t && t <= tap->leave;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void detected(tap_t *tap, int64_t t, result_t *r) {
+    r->latencies[r->detected++] = (double)(t - tap->arrive);
+    if (tap->leave > t + tap->react) {
+        tap->leave = t + tap->react;
+    }
+}
+
+static void run_fixed(tap_t *taps, size_t n, int days, result_t *r) {
+    int64_t t = 0;
+    size_t i = 0;
+    int64_t end = DAY_MS * days;
+    while (t < end && i < n) {
+        while (i < n && taps[i].leave < t) {
+            r->missed++;
+            i++;
+        }
+        if (i >= n) break;
+        r->polls++;
+        if (card_in_field(&taps[i], t)) {
+            t += POLL_READ_MS;
+            detected(&taps[i], t, r);
+            i++;
+            t += 1000;
+        } else {
+            t += POLL_EMPTY_MS + 125;
+        }
+    }
+    r->radio_on_ms = (uint64_t)end;
+    r->span_ms = end;
+}
+
+typedef struct {
+    tap_t *taps;
+    size_t n;
+    size_t i;
+    rfid_sched_t s;
+    int64_t next;
+} sim_reader_t;
+
+// Readers share one bus: every RC522 operation holds it for its full
+// duration, and the next due reader after the last one served goes next.
+static void run_bus(sim_reader_t *rd, int count, int days, const rfid_sched_config_t *cfg,
+                    result_t *res, int64_t *bus_busy_ms) {
+    int64_t t = 0;
+    int64_t end = DAY_MS * days;
+    int64_t busy = 0;
+    int rr = 0;
+    for (int k = 0; k < count; k++) {
+        rfid_sched_init(&rd[k].s, cfg, t);
+        rd[k].i = 0;
+        rd[k].next = 0;
+    }
+
+    while (t < end) {
+        int pick = -1;
+        int64_t earliest = INT64_MAX;
+        for (int j = 0; j < count; j++) {
+            int k = (rr + j) % count;
+            if (rd[k].next <= t) {
+                pick = k;
+                break;
+            }
+            if (rd[k].next < earliest) {
+                earliest = rd[k].next;
+            }
+        }
+        if (pick < 0) {
+            t = earliest;
+            continue;
+        }
+        rr = (pick + 1) % count;
+
+        sim_reader_t *r = &rd[pick];
+        result_t *out = &res[pick];
+        while (!r->s.awaiting_removal && r->i < r->n && r->taps[r->i].leave < t) {
+            out->missed++;
+            r->i++;
+        }
+        tap_t *tap = r->i < r->n ? &r->taps[r->i] : NULL;
+        int64_t start = t;
+
+        if (!r->s.antenna_on) {
+            rfid_sched_antenna_changed(&r->s, true, t);
+            r->next = t + ANTENNA_SETTLE_MS;
+            continue;
+        }
+
+        if (r->s.awaiting_removal) {
+            t += REMOVAL_CHECK_COST;
+            bool removed = rfid_sched_on_removal_check(&r->s, tap && card_in_field(tap, t), t);
+            if (removed) {
+                r->i++;
+            }
+            r->next = t + (removed ? 0 : cfg->removal_check_ms);
+        } else if (tap && card_in_field(tap, t)) {
+            t += POLL_READ_MS;
+            detected(tap, t, out);
+            rfid_sched_on_card(&r->s, t);
+            r->next = t + cfg->removal_check_ms;
+        } else {
+            t += POLL_EMPTY_MS;
+            uint32_t delay = rfid_sched_on_idle_poll(&r->s, t, (int)((t / 3600000) % 24));
+            if (rfid_sched_antenna_may_idle(&r->s)) {
+                rfid_sched_antenna_changed(&r->s, false, t);
+            }
+            r->next = t + delay;
+        }
+        busy += t - start;
+    }
+
+    for (int k = 0; k < count; k++) {
+        rfid_sched_stats_t st = rfid_sched_stats(&rd[k].s, t);
+        res[k].radio_on_ms = st.radio_on_ms;
+        res[k].polls = st.polls;
+        res[k].span_ms = t;
+    }
+    if (bus_busy_ms) {
+        *bus_busy_ms = busy;
+    }
+}
+
+static rfid_sched_config_t make_config(rfid_sched_profile_t profiles[2], uint32_t idle_max_ms) {
+    profiles[0] = (rfid_sched_profile_t){.start_hour = 7, .end_hour = 22, .fast_ms = 50, .idle_max_ms = idle_max_ms};
+    profiles[1] = (rfid_sched_profile_t){.start_hour = 22, .end_hour = 7, .fast_ms = 100, .idle_max_ms = 2000};
+    return (rfid_sched_config_t){
+        .profiles = profiles,
+        .profile_count = 2,
+        .fallback = {.fast_ms = 50, .idle_max_ms = idle_max_ms},
+        .hot_window_ms = 60000,
+        .antenna_off_threshold_ms = 100,
+        .removal_check_ms = 50,
+        .removal_misses = 2,
+    };
+}
+
+static void print_result(const result_t *r) {
+    qsort(r->latencies, r->detected, sizeof(double), cmp_double);
+    double sum = 0;
+    for (size_t k = 0; k < r->detected; k++) sum += r->latencies[k];
+    double avg = r->detected ? sum / (double)r->detected : 0;
+    double p95 = r->detected ? r->latencies[(size_t)(0.95 * (double)(r->detected - 1))] : 0;
+    double p99 = r->detected ? r->latencies[(size_t)(0.99 * (double)(r->detected - 1))] : 0;
+    printf("%-22s detected=%-6zu missed=%-4zu avg=%6.1f ms  p95=%6.1f ms  p99=%6.1f ms  radio_on=%5.1f%%  polls=%" PRIu64 "\n",
+           r->name, r->detected, r->missed, avg, p95, p99,
+           100.0 * (double)r->radio_on_ms / (double)r->span_ms, r->polls);
+}
+
+int main(int argc, char **argv) {
+    int days = argc > 1 ? atoi(argv[1]) : 7;
+    rng_state = argc > 2 ? strtoull(argv[2], NULL, 10) : 0x9E3779B97F4A7C15ULL;
+    if (days <= 0) days = 1;
+    if (rng_state == 0) rng_state = 1;
+
+    size_t max_taps = (size_t)days * 2000;
+    tap_t *taps = calloc(max_taps, sizeof(tap_t));
+    size_t n = generate_taps(taps, max_taps, days);
+    printf("Simulated %d day(s), %zu taps\n\n", days, n);
+
+    tap_t *work = calloc(max_taps, sizeof(tap_t));
+
+    memcpy(work, taps, n * sizeof(tap_t));
+    result_t fixed = {.name = "fixed 125ms/1000ms", .latencies = calloc(n + 1, sizeof(double))};
+    run_fixed(work, n, days, &fixed);
+    print_result(&fixed);
+
+    // Sweep the opening-hours back-off ceiling; nights always back off to 2 s.
+    static const uint32_t idle_max[] = {100, 150, 200, 300, 500};
+    for (size_t v = 0; v < sizeof(idle_max) / sizeof(idle_max[0]); v++) {
+        rfid_sched_profile_t profiles[2];
+        rfid_sched_config_t cfg = make_config(profiles, idle_max[v]);
+        char name[32];
+        snprintf(name, sizeof(name), "adaptive idle<=%" PRIu32 "ms", idle_max[v]);
+        result_t r = {.name = name, .latencies = calloc(n + 1, sizeof(double))};
+        memcpy(work, taps, n * sizeof(tap_t));
+        sim_reader_t reader = {.taps = work, .n = n};
+        run_bus(&reader, 1, days, &cfg, &r, NULL);
+        print_result(&r);
+        free(r.latencies);
+    }
+
+    // Readers sharing one bus, each at a gate with its own queue of taps.
+    printf("\nShared SPI bus, idle<=150ms, one tap stream per reader:\n");
+    enum { MAX_READERS = 4 };
+    tap_t *gate_taps[MAX_READERS];
+    size_t gate_n[MAX_READERS];
+    gate_taps[0] = taps;
+    gate_n[0] = n;
+    for (int k = 1; k < MAX_READERS; k++) {
+        gate_taps[k] = calloc(max_taps, sizeof(tap_t));
+        gate_n[k] = generate_taps(gate_taps[k], max_taps, days);
+    }
+    for (int count = 1; count <= MAX_READERS; count++) {
+        rfid_sched_profile_t profiles[2];
+        rfid_sched_config_t cfg = make_config(profiles, 150);
+        sim_reader_t rd[MAX_READERS] = {0};
+        result_t res[MAX_READERS] = {0};
+        char names[MAX_READERS][32];
+        for (int k = 0; k < count; k++) {
+            rd[k].taps = calloc(gate_n[k] + 1, sizeof(tap_t));
+            memcpy(rd[k].taps, gate_taps[k], gate_n[k] * sizeof(tap_t));
+            rd[k].n = gate_n[k];
+            snprintf(names[k], sizeof(names[k]), "%d reader(s): #%d", count, k + 1);
+            res[k].name = names[k];
+            res[k].latencies = calloc(gate_n[k] + 1, sizeof(double));
+        }
+        int64_t busy = 0;
+        run_bus(rd, count, days, &cfg, res, &busy);
+        for (int k = 0; k < count; k++) {
+            print_result(&res[k]);
+            free(res[k].latencies);
+            free(rd[k].taps);
+        }
+        printf("%-22s bus busy=%5.1f%%\n\n", "", 100.0 * (double)busy / (double)(DAY_MS * days));
+    }
+    for (int k = 1; k < MAX_READERS; k++) {
+        free(gate_taps[k]);
+    }
+
+    free(fixed.latencies);
+    free(work);
+    free(taps);
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Allocation soak for the firmware's scan path.
+//
+// Compiles main/main.c against host/idf_shim with malloc, calloc, realloc and
+// free wrapped, boots it, and plays taps by registered and unregistered cards
+// through handle_card() and the uplink task's per-scan step, with uplink
+// housekeeping (unknown-card summary, UID filter refresh) between taps as on
+// the device. There are far more registered cards than rfid_cache holds, so
+// taps keep going to the admin API for a lookup. The simulated gateway
+// answers a few percent of events with 429 and Retry-After, so held events
+// and their resends are part of the scan path too. After a warm-up it
+// asserts that the scan path performs no heap allocations at all;
+// housekeeping allocations are reported separately.
+//
+// Build and run from esp32/:
+//   gcc -O2 -Ihost/idf_shim -Imain -Imain/include -Icomponents/rc522 -Icomponents/ssd1306
+//       -Icomponents/rfid_sched -Icomponents/uid_filter -o /tmp/scan_soak
+//       host/scan_soak.c host/idf_shim/idf_shim.c components/rfid_sched/rfid_sched.c
+//       components/uid_filter/uid_filter.c -lm
+//       -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+//   /tmp/scan_soak 200000   # taps after warm-up; exits 1 if any allocate
+//
+// SHIM_LOG=W (or I, D) shows the firmware's log output.
+
+#include <math.h>
+
+#include "main.c"
+
+// Heap accounting --------------------------------------------------------
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void __real_free(void *p);
+
+static uint64_t heap_allocs;
+static uint64_t heap_frees;
+
+void *__wrap_malloc(size_t size) { heap_allocs++; return __real_malloc(size); }
+void *__wrap_calloc(size_t n, size_t size) { heap_allocs++; return __real_calloc(n, size); }
+void *__wrap_realloc(void *p, size_t size) { heap_allocs++; return __real_realloc(p, size); }
+void __wrap_free(void *p) { heap_frees += p != NULL; __real_free(p); }
+
+// Hardware the soak does not exercise ------------------------------------
+
+esp_err_t ssd1306_init(const ssd1306_config_t *config) { return ESP_OK; }
+void ssd1306_fb_clear(void) {}
+uint8_t ssd1306_fb_text(uint8_t page, uint8_t x, uint8_t scale, const char *text) { return x; }
+uint8_t ssd1306_fb_text_centered(uint8_t page, uint8_t scale, const char *text) { return 0; }
+bool ssd1306_fb_text_wrapped(uint8_t page, uint8_t pages, uint8_t scale, const char *text) { return true; }
+bool ssd1306_text_fits(uint8_t pages, uint8_t scale, const char *text) { return true; }
+esp_err_t ssd1306_flush(void) { return ESP_OK; }
+esp_err_t rc522_bus_init(spi_host_device_t host, int mosi_io, int miso_io, int sck_io) { return ESP_OK; }
+esp_err_t rc522_attach(rc522_t *r, spi_host_device_t host, const rc522_config_t *cfg) { r->cfg = *cfg; return ESP_OK; }
+esp_err_t rc522_init(rc522_t *r) { return ESP_OK; }
+esp_err_t rc522_get_tag(rc522_t *r, uint8_t *uid, size_t *uid_len) { return ESP_ERR_NOT_FOUND; }
+esp_err_t rc522_card_present(rc522_t *r) { return ESP_ERR_NOT_FOUND; }
+esp_err_t rc522_antenna_on(rc522_t *r) { return ESP_OK; }
+esp_err_t rc522_antenna_off(rc522_t *r) { return ESP_OK; }
+bool rc522_supervise(rc522_t *r, esp_err_t err) { return false; }
+bool rc522_health_check(rc522_t *r) { return false; }
+
+// Cards and the simulated backend ----------------------------------------
+
+#define REGISTERED_CARDS    200  // well over RFID_CACHE_SIZE, so taps keep missing the cache
+#define UNKNOWN_CARDS       40   // rejected by the filter
+#define FALSE_POSITIVES     2    // unknown, but let through by the filter
+#define FILTER_ETAG         "\"soak-filter\""
+
+typedef struct {
+    uint8_t uid[5];
+    char hex[11];
+} card_t;
+
+static card_t registered[REGISTERED_CARDS];
+static card_t unknown[UNKNOWN_CARDS + FALSE_POSITIVES];
+_Static_assert(REGISTERED_CARDS > 4 * RFID_CACHE_SIZE, "the soak must exercise the lookup path");
+
+static uint8_t filter_blob[UID_FILTER_HEADER_LEN + 8 + REGISTERED_CARDS * 2]; // ~10 bits per card
+static size_t filter_len;
+
+static struct {
+    uint64_t events, throttled, lookups, lookup_misses, filter_200, filter_304, summaries, unknown_taps;
+} served;
+
+static uint32_t rng_state = 12345;
+static uint32_t rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static void random_card(card_t *c) {
+    for (int i = 0; i < 5; i++) {
+        c->uid[i] = (uint8_t)rng();
+        snprintf(&c->hex[i * 2], 3, "%02X", c->uid[i]);
+    }
+}
+
+static uint64_t fnv1a64(const char *s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Same layout and sizing as build_uid_filter() in admin/main.py (1% FP rate).
+static void build_filter(void) {
+    size_t n = REGISTERED_CARDS;
+    uint32_t m = (uint32_t)ceil(-(double)n * log(0.01) / (log(2) * log(2)));
+    m = m < 64 ? 64 : (m + 7) / 8 * 8;
+    int k = (int)lround((double)m / n * log(2));
+    k = k < 1 ? 1 : k > 16 ? 16 : k;
+    uint8_t *bits = filter_blob + UID_FILTER_HEADER_LEN;
+    memset(filter_blob, 0, sizeof(filter_blob));
+    for (size_t c = 0; c < n; c++) {
+        uint64_t h = fnv1a64(registered[c].hex);
+        uint64_t h1 = h & 0xFFFFFFFFu, h2 = (h >> 32) | 1;
+        for (int j = 0; j < k; j++) {
+            uint32_t i = (uint32_t)((h1 + (uint64_t)j * h2) % m);
+            bits[i >> 3] |= (uint8_t)(1u << (i & 7));
+        }
+    }
+    memcpy(filter_blob, "UIDF", 4);
+    filter_blob[4] = UID_FILTER_VERSION;
+    filter_blob[5] = (uint8_t)k;
+    for (int b = 0; b < 4; b++) {
+        filter_blob[8 + b] = (uint8_t)(m >> (8 * b));
+        filter_blob[12 + b] = (uint8_t)(n >> (8 * b));
+    }
+    filter_len = UID_FILTER_HEADER_LEN + m / 8;
+}
+
+static void make_cards(void) {
+    for (int i = 0; i < REGISTERED_CARDS; i++) {
+        random_card(&registered[i]);
+    }
+    build_filter();
+    uid_filter_t f;
+    uid_filter_parse(&f, filter_blob, filter_len);
+    int rejected = 0, passed = 0;
+    while (rejected < UNKNOWN_CARDS || passed < FALSE_POSITIVES) {
+        card_t c;
+        random_card(&c);
+        if (!uid_filter_maybe_contains(&f, c.hex)) {
+            if (rejected < UNKNOWN_CARDS) unknown[rejected++] = c;
+        } else if (passed < FALSE_POSITIVES) {
+            bool is_registered = false;
+            for (int i = 0; i < REGISTERED_CARDS; i++) {
+                is_registered |= strcmp(registered[i].hex, c.hex) == 0;
+            }
+            if (!is_registered) unknown[UNKNOWN_CARDS + passed++] = c;
+        }
+    }
+}
+
+static void server(const char *method, const char *url, const char *headers, const char *body,
+                   size_t body_len, shim_http_response_t *resp) {
+    static char json[256];
+    const char *path = strchr(url, '/');
+    if (strcmp(method, "POST") == 0 && strstr(path, "/api/events")) {
+        if (rng() % 100 < 3) {
+            served.throttled++;
+            resp->status = 429;
+            resp->retry_after_s = 1;
+            return;
+        }
+        served.events++;
+        resp->status = 201;
+    } else if (strcmp(method, "POST") == 0 && strstr(path, "/api/rfid/unknown-summary")) {
+        served.summaries++;
+        for (const char *p = body; (p = strstr(p, "\"count\":")) != NULL; p++) {
+            served.unknown_taps += strtoull(p + 8, NULL, 10);
+        }
+        resp->status = 200;
+        resp->body = "{\"registered\":[]}";
+        resp->body_len = strlen(resp->body);
+    } else if (strcmp(path, "/health") == 0) {
+        resp->status = 200;
+    } else if (strstr(path, "/rfid/filter")) {
+        snprintf(resp->etag, sizeof(resp->etag), "%s", FILTER_ETAG);
+        if (strstr(headers, "If-None-Match: " FILTER_ETAG)) {
+            served.filter_304++;
+            resp->status = 304;
+        } else {
+            served.filter_200++;
+            resp->status = 200;
+            resp->body = filter_blob;
+            resp->body_len = filter_len;
+        }
+    } else if (strcmp(method, "POST") == 0 && strstr(path, "/students/lookup")) {
+        char uid[21] = "";
+        const char *p = body ? strstr(body, "\"rfid_uid\":\"") : NULL;
+        if (p) {
+            sscanf(p + 12, "%20[0-9A-F]", uid);
+        }
+        served.lookups++;
+        for (int i = 0; i < REGISTERED_CARDS; i++) {
+            if (strcmp(uid, registered[i].hex) == 0) {
+                snprintf(json, sizeof(json), "{\"name\":\"Student %d\",\"rfid_uid\":\"%s\",\"next_event_type\":\"entry\"}",
+                         i, uid);
+                resp->status = 200;
+                resp->body = json;
+                resp->body_len = strlen(json);
+                return;
+            }
+        }
+        served.lookup_misses++;
+        resp->status = 404;
+        resp->body = "{\"detail\":\"Student not found\"}";
+        resp->body_len = strlen(resp->body);
+    }
+}
+
+// Driver -----------------------------------------------------------------
+
+typedef struct {
+    uint64_t taps, scan_allocs, housekeeping_allocs, housekeeping_runs;
+} soak_stats_t;
+
+static void play(uint64_t taps, soak_stats_t *st) {
+    for (uint64_t t = 0; t < taps; t++) {
+        shim_now_us += 700 * 1000; // some re-taps land inside the debounce window
+        const card_t *card = rng() % 10 < 7 ? &registered[rng() % REGISTERED_CARDS]
+                                            : &unknown[rng() % (UNKNOWN_CARDS + FALSE_POSITIVES)];
+
+        uint64_t before = heap_allocs;
+        handle_card(&readers[0], card->uid, sizeof(card->uid));
+        scan_event_t scan;
+        while (xQueueReceive(scan_queue, &scan, 0) == pdTRUE) {
+            uplink_handle_scan(&scan);
+        }
+        backlog_send();
+        st->scan_allocs += heap_allocs - before;
+
+        before = heap_allocs;
+        int64_t now = uptime_ms();
+        bool due = now >= next_summary_ms || now >= next_filter_ms;
+        uplink_housekeeping(now, true);
+        st->housekeeping_allocs += heap_allocs - before;
+        st->housekeeping_runs += due;
+        st->taps++;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t taps = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    make_cards();
+    shim_http_server = server;
+
+    uint64_t boot_allocs = heap_allocs;
+    app_main();
+    for (size_t i = 0; i < READER_COUNT; i++) {
+        rc522_attach(&readers[i].dev, RC522_SPI_HOST, &reader_configs[i]);
+    }
+    http_clients_init();
+    xEventGroupSetBits(app_events, WIFI_CONNECTED_BIT);
+    uplink_check_online(); // pre-warm, as uplink_task does on GOT_IP
+    boot_allocs = heap_allocs - boot_allocs;
+
+    soak_stats_t warm = {0};
+    play(2000, &warm);
+
+    soak_stats_t st = {0};
+    memset(&served, 0, sizeof(served));
+    int connects = shim_http_connects;
+    play(taps, &st);
+
+    printf("boot:          %" PRIu64 " allocations (HTTP clients, pre-warm)\n", boot_allocs);
+    printf("warm-up:       %" PRIu64 " taps, %" PRIu64 " allocations in the scan path\n",
+           warm.taps, warm.scan_allocs);
+    printf("soak:          %" PRIu64 " taps over %.1f simulated hours\n", st.taps, (double)taps * 0.7 / 3600);
+    printf("  backlog:     %" PRIu64 " events answered 429 and held, %u still held at the end\n",
+           served.throttled, backlog_count);
+    printf("  served:      %" PRIu64 " events, %" PRIu64 " lookups (%" PRIu64 " 404), filter %" PRIu64 "x200 %" PRIu64
+           "x304, %" PRIu64 " summaries with %" PRIu64 " unknown taps\n",
+           served.events, served.lookups, served.lookup_misses, served.filter_200, served.filter_304,
+           served.summaries, served.unknown_taps);
+    printf("  connections: %d opened\n", shim_http_connects - connects);
+    printf("  scan path:   %" PRIu64 " allocations (%.3f per tap)\n", st.scan_allocs,
+           st.taps ? (double)st.scan_allocs / (double)st.taps : 0.0);
+    printf("  housekeeping:%" PRIu64 " allocations over %" PRIu64 " runs (URL switches on the shared clients)\n",
+           st.housekeeping_allocs, st.housekeeping_runs);
+    printf("  heap:        %" PRIu64 " allocations, %" PRIu64 " frees in total\n", heap_allocs, heap_frees);
+
+    if (served.lookups == 0) {
+        printf("FAIL: no lookups after warm-up, so the lookup path went untested\n");
+        return 1;
+    }
+    if (st.scan_allocs != 0) {
+        printf("FAIL: the scan path allocated in steady state\n");
+        return 1;
+    }
+    printf("OK: no allocations per scan in steady state\n");
+    return 0;
+}
@@ -0,0 +1,239 @@
+"""Full vs resumed TLS handshakes against a local TLS stand-in.
+
+The device's HTTP clients keep their TLS session (save_client_session), so
+when the gateway or a proxy closes an idle keep-alive connection the next
+tap resumes the session instead of doing a full handshake. This bench puts
+a number on that: a local server that closes the connection after every
+request (the worst case, a tap after each idle timeout), and a client that
+connects either with a fresh context every time or with the session of the
+previous connection. The client drives TLS through memory BIOs, so it counts
+the bytes and the round trips the device would put on the air, and can add
+a simulated WiFi round-trip time to each flight.
+
+Certificates are generated per run with the openssl CLI: a CA and a leaf for
+localhost, with the server sending leaf + CA, as a server with one
+intermediate does.
+
+    python3 host/tls_resume_bench.py                      # TLS 1.2, EC P-256, tickets
+    python3 host/tls_resume_bench.py --no-tickets         # TLS 1.2 session-ID resumption
+    python3 host/tls_resume_bench.py --tls 1.3 --key rsa --rtt-ms 40 --runs 100
+
+Client CPU is the host's. On an ESP32 the ECDHE and signature verification
+that a resumed TLS 1.2 handshake skips take hundreds of milliseconds, so the
+byte and round-trip counts are the portable part of the result.
+"""
+
+import argparse
+import os
+import socket
+import ssl
+import statistics
+import subprocess
+import tempfile
+import threading
+import time
+
+REQUEST = (b"POST /api/events HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+           b"Content-Length: 2\r\n\r\n{}")
+RESPONSE = b"HTTP/1.1 201 Created\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+
+
+def make_certs(workdir, key):
+    newkey = ["-newkey", "rsa:2048"] if key == "rsa" else ["-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1"]
+
+    def path(name):
+        return os.path.join(workdir, name)
+
+    def openssl(*args):
+        subprocess.run(["openssl", *args], check=True, capture_output=True)
+
+    with open(path("san.ext"), "w") as f:
+        f.write("subjectAltName=DNS:localhost\n")
+    openssl("req", "-x509", *newkey, "-nodes", "-days", "1", "-subj", "/CN=tls-bench-ca",
+            "-keyout", path("ca.key"), "-out", path("ca.pem"))
+    openssl("req", *newkey, "-nodes", "-subj", "/CN=localhost",
+            "-keyout", path("leaf.key"), "-out", path("leaf.csr"))
+    openssl("x509", "-req", "-days", "1", "-in", path("leaf.csr"), "-CA", path("ca.pem"),
+            "-CAkey", path("ca.key"), "-CAcreateserial", "-extfile", path("san.ext"), "-out", path("leaf.pem"))
+    with open(path("chain.pem"), "w") as out:
+        for name in ("leaf.pem", "ca.pem"):
+            with open(path(name)) as f:
+                out.write(f.read())
+    return path("chain.pem"), path("leaf.key"), path("ca.pem")
+
+
+def tls_version(v):
+    return ssl.TLSVersion.TLSv1_3 if v == "1.3" else ssl.TLSVersion.TLSv1_2
+
+
+class StandIn:
+    """One request per connection, then close, like a server whose keep-alive
+    timeout expired between taps."""
+
+    def __init__(self, chain, key, version, tickets):
+        self.ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        self.ctx.load_cert_chain(chain, key)
+        self.ctx.minimum_version = self.ctx.maximum_version = version
+        if not tickets:
+            self.ctx.options |= ssl.OP_NO_TICKET
+        self.sock = socket.create_server(("127.0.0.1", 0))
+        self.port = self.sock.getsockname()[1]
+        threading.Thread(target=self.serve, daemon=True).start()
+
+    def serve(self):
+        while True:
+            conn, _ = self.sock.accept()
+            try:
+                with self.ctx.wrap_socket(conn, server_side=True) as tls:
+                    data = b""
+                    while b"{}" not in data:
+                        chunk = tls.recv(4096)
+                        if not chunk:
+                            break
+                        data += chunk
+                    tls.sendall(RESPONSE)
+                    # close_notify: OpenSSL only keeps a session ID resumable
+                    # after a clean shutdown.
+                    tls.unwrap()
+            except (ssl.SSLError, OSError):
+                pass
+
+
+class Sample:
+    def __init__(self):
+        self.handshake_ms = 0.0
+        self.cpu_ms = 0.0
+        self.sent = 0
+        self.received = 0
+        self.round_trips = 0
+        self.reused = False
+
+
+def one_request(ctx, port, session, rtt_s):
+    """Connect, handshake, send one event and read the reply. Returns the
+    sample and the session to resume next time."""
+    s = Sample()
+    sock = socket.create_connection(("127.0.0.1", port))
+    incoming, outgoing = ssl.MemoryBIO(), ssl.MemoryBIO()
+    tls = ctx.wrap_bio(incoming, outgoing, server_hostname="localhost", session=session)
+
+    flight = [False]  # sent something the server has not answered yet
+
+    def flush():
+        data = outgoing.read()
+        if data:
+            sock.sendall(data)
+            s.sent += len(data)
+            flight[0] = True
+
+    def wait_for_peer():
+        # Waiting for the answer to our last flight is one round trip on the
+        # air; further reads of the same answer are not.
+        if flight[0]:
+            s.round_trips += 1
+            flight[0] = False
+            if rtt_s:
+                time.sleep(rtt_s)
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError("server closed the connection")
+        s.received += len(chunk)
+        incoming.write(chunk)
+
+    start = time.perf_counter()
+    while True:
+        c0 = time.thread_time()
+        try:
+            tls.do_handshake()
+            done = True
+        except ssl.SSLWantReadError:
+            done = False
+        s.cpu_ms += (time.thread_time() - c0) * 1000
+        flush()
+        if done:
+            break
+        wait_for_peer()
+    s.handshake_ms = (time.perf_counter() - start) * 1000
+    s.reused = tls.session_reused
+
+    # The request, then read until the server closes; TLS 1.3 tickets arrive
+    # here, after the handshake.
+    tls.write(REQUEST)
+    flush()
+    while True:
+        try:
+            if not tls.read(4096):
+                break
+        except ssl.SSLWantReadError:
+            try:
+                wait_for_peer()
+            except ConnectionError:
+                break
+        except (ssl.SSLZeroReturnError, ssl.SSLEOFError):
+            break
+    session = tls.session
+    sock.close()
+    return s, session
+
+
+def run(ctx_factory, port, runs, resume, rtt_s):
+    samples = []
+    session = None
+    ctx = ctx_factory()
+    for _ in range(runs):
+        if not resume:
+            ctx = ctx_factory()
+            session = None
+        s, session = one_request(ctx, port, session, rtt_s)
+        samples.append(s)
+    # The first resumed-mode connection is necessarily a full handshake.
+    return samples[1:] if resume else samples
+
+
+def summarize(label, samples):
+    def med(attr):
+        return statistics.median(getattr(x, attr) for x in samples)
+
+    reused = sum(x.reused for x in samples)
+    print(f"{label:<9} handshake p50 {med('handshake_ms'):7.2f} ms   client CPU p50 {med('cpu_ms'):6.2f} ms   "
+          f"round trips {med('round_trips'):.0f} (incl. request)   bytes out/in {med('sent'):.0f}/{med('received'):.0f}   "
+          f"reused {reused}/{len(samples)}")
+    return {attr: med(attr) for attr in ("handshake_ms", "cpu_ms", "round_trips", "sent", "received")}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--runs", type=int, default=200, help="connections per mode")
+    ap.add_argument("--tls", choices=("1.2", "1.3"), default="1.2", help="protocol version")
+    ap.add_argument("--key", choices=("ec", "rsa"), default="ec", help="server key type (P-256 or RSA-2048)")
+    ap.add_argument("--no-tickets", action="store_true", help="server issues no tickets (session-ID resumption)")
+    ap.add_argument("--rtt-ms", type=float, default=0, help="simulated round-trip time added per flight")
+    args = ap.parse_args()
+
+    version = tls_version(args.tls)
+    with tempfile.TemporaryDirectory() as workdir:
+        chain, key, ca = make_certs(workdir, args.key)
+        server = StandIn(chain, key, version, tickets=not args.no_tickets)
+
+        def client_ctx():
+            ctx = ssl.create_default_context(cafile=ca)
+            ctx.minimum_version = ctx.maximum_version = version
+            return ctx
+
+        rtt_s = args.rtt_ms / 1000
+        print(f"TLS {args.tls}, {args.key.upper()} server key, "
+              f"{'session IDs' if args.no_tickets else 'session tickets'}, "
+              f"{args.rtt_ms:g} ms simulated RTT, {args.runs} connections per mode\n")
+        full = summarize("full", run(client_ctx, server.port, args.runs, False, rtt_s))
+        resumed = summarize("resumed", run(client_ctx, server.port, args.runs, True, rtt_s))
+
+    def saving(attr):
+        return 100 * (1 - resumed[attr] / full[attr]) if full[attr] else 0.0
+
+    print(f"\nresumption saves {saving('handshake_ms'):.0f}% of handshake time, {saving('cpu_ms'):.0f}% of client CPU, "
+          f"{saving('received'):.0f}% of bytes received and {full['round_trips'] - resumed['round_trips']:.0f} "
+          f"round trip(s) per reconnect")
+
+
+if __name__ == "__main__":
+    main()
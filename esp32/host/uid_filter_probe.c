@@ -0,0 +1,50 @@
+// Host-side probe for the registered-UID filter served by GET /rfid/filter.
+//
+// Reads a filter file and reports, for each UID given, whether the firmware's
+// uid_filter would let it through ("maybe") or reject it ("no"). Used to check
+// that components/uid_filter and build_uid_filter in admin/main.py agree.
+//
+// Build and run from esp32/:
+//   gcc -O2 -Icomponents/uid_filter -o /tmp/uid_filter_probe
+//       host/uid_filter_probe.c components/uid_filter/uid_filter.c
+//   curl -s http://localhost:8001/rfid/filter -o /tmp/filter.bin
+//   /tmp/uid_filter_probe /tmp/filter.bin 04A1B2C3 DEADBEEF
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "uid_filter.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s filter.bin [UID...]\n", argv[0]);
+        return 2;
+    }
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = malloc(len > 0 ? (size_t)len : 1);
+    if (!buf || fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+        fprintf(stderr, "failed to read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(fp);
+
+    uid_filter_t f;
+    if (!uid_filter_parse(&f, buf, (size_t)len)) {
+        fprintf(stderr, "%s: not a valid UID filter\n", argv[1]);
+        return 1;
+    }
+    printf("filter: n=%" PRIu32 " m_bits=%" PRIu32 " k=%u (%ld bytes)\n", f.n, f.m_bits, f.k, len);
+    for (int i = 2; i < argc; i++) {
+        printf("%s %s\n", argv[i], uid_filter_maybe_contains(&f, argv[i]) ? "maybe" : "no");
+    }
+    free(buf);
+    return 0;
+}
@@ -22,6 +22,45 @@
 #define RC522_SDA_PIN 5    // RC522 SDA/SS -> ESP32 GPIO5 (D5)
 #define RC522_RST_PIN 4    // RC522 RST -> ESP32 GPIO4 (D4)
 
+// Readers on the RC522 SPI bus above, polled round-robin. Each needs its own
+// SDA (CS) pin; RST may be -1 (soft reset only) or shared, in which case
+// resetting one reader resets all of them and the others recover on their
+// next health check. Gates named "entry"/"exit" fix the event direction; any
+// other name lets the backend toggle entry/exit per student.
+#define RC522_READERS { \
+    { .gate_id = "main", .cs_pin = RC522_SDA_PIN, .rst_pin = RC522_RST_PIN }, \
+}
+
+// Adaptive RFID polling (components/rfid_sched). Hours are local time, so
+// DEVICE_TZ must be a POSIX TZ string for the library's location.
+#define DEVICE_TZ "IST-5:30"
+#define RFID_POLL_FAST_MS 50              // poll interval while cards were seen recently
+#define RFID_POLL_HOT_WINDOW_MS 60000     // how long "recently" lasts
+#define RFID_POLL_OPEN_START_HOUR 7       // opening hours profile
+#define RFID_POLL_OPEN_END_HOUR 22
+#define RFID_POLL_OPEN_IDLE_MAX_MS 150    // back-off ceiling during opening hours
+#define RFID_POLL_CLOSED_IDLE_MAX_MS 2000 // back-off ceiling overnight
+#define RFID_ANTENNA_OFF_THRESHOLD_MS 100 // antenna off between polls at/above this interval
+#define RFID_REMOVAL_CHECK_MS 50          // "card removed" check interval after a read
+
+// Registered-UID filter from ADMIN_API_URL/rfid/filter (components/uid_filter).
+// Cards the filter rejects show "Not registered" without any HTTP and are
+// reported to the gateway in a periodic summary instead of per tap. The filter
+// is kept in NVS, so size UID_FILTER_MAX_BYTES to fit the nvs partition
+// (about 8 KB covers 6,800 cards at the admin API's default 1% FP rate).
+#define UID_FILTER_REFRESH_MS 60000       // conditional GET interval (ETag)
+#define UID_FILTER_MAX_BYTES 8208         // header + bits; larger filters are ignored
+#define UNKNOWN_SUMMARY_FLUSH_MS 60000    // POST /api/rfid/unknown-summary interval
+#define UNKNOWN_SUMMARY_SLOTS 32          // distinct unknown UIDs held between flushes
+
+// Events the gateway has not accepted (429/503 when it is shedding load, 5xx,
+// no connection) are held in RAM and resent oldest first, no sooner than its
+// Retry-After or, without one, an exponential back-off. Held events do not
+// survive a reboot; when the backlog is full the oldest is dropped.
+#define EVENT_BACKLOG_LEN 64              // events held while the gateway pushes back
+#define EVENT_RETRY_MIN_MS 1000           // first back-off without a Retry-After
+#define EVENT_RETRY_MAX_MS 60000          // ceiling for back-off and Retry-After
+
 // OLED Display (SSD1306 over I2C)
 #define OLED_SDA_PIN 21
 #define OLED_SCL_PIN 22
@@ -1,11 +1,15 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <inttypes.h>
+#include <time.h>
 #include <sys/time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_err.h"
 #include "esp_wifi.h"
@@ -13,106 +17,212 @@
 #include "esp_log.h"
 #include "esp_http_client.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_netif_sntp.h"
 #include "nvs_flash.h"
-#include "driver/gpio.h"
-#include "driver/spi_master.h"
+#include "nvs.h"
+#include "rc522.h"
 #include "ssd1306.h"
+#include "rfid_sched.h"
+#include "uid_filter.h"
 #include "config.h"
 
 static const char *TAG = "ATTENDANCE";
 
-// Debounce window when sending events to the backend
-static int64_t last_scan_time = 0;
+// Debounce window for repeated reads of the same card on one reader
 static const int64_t DEBOUNCE_MS = 2000;
 
-// SPI handle for direct MFRC522 communication
-static spi_device_handle_t rc522_spi = NULL;
-static bool rc522_initialized = false;
-
-// MFRC522 register map 
-#define RC522_REG_COMMAND          0x01
-#define RC522_REG_COMM_IE          0x02
-#define RC522_REG_COMM_IRQ         0x04
-#define RC522_REG_DIV_IRQ          0x05
-#define RC522_REG_ERROR            0x06
-#define RC522_REG_STATUS1          0x07
-#define RC522_REG_FIFO_DATA        0x09
-#define RC522_REG_FIFO_LEVEL       0x0A
-#define RC522_REG_CONTROL          0x0C
-#define RC522_REG_BIT_FRAMING      0x0D
-#define RC522_REG_MODE             0x11
-#define RC522_REG_TX_CONTROL       0x14
-#define RC522_REG_TX_ASK           0x15
-#define RC522_REG_CRC_RESULT_L     0x22
-#define RC522_REG_CRC_RESULT_H     0x21
-#define RC522_REG_RFCFG            0x26
-#define RC522_REG_T_MODE           0x2A
-#define RC522_REG_T_PRESCALER      0x2B
-#define RC522_REG_T_RELOAD_L       0x2D
-#define RC522_REG_T_RELOAD_H       0x2C
-#define RC522_REG_VERSION          0x37
-
-// MFRC522 command set 
-#define RC522_CMD_IDLE             0x00
-#define RC522_CMD_CALC_CRC         0x03
-#define RC522_CMD_TRANSCEIVE       0x0C
-#define RC522_CMD_SOFT_RESET       0x0F
-
-// ISO14443A commands
-#define PICC_REQIDL                0x26
-#define PICC_ANTICOLL_CL1          0x93
-
-// Utility macros
-#define MFRC522_MAX_LEN            18
+// RC522 readers on the shared SPI bus, polled round-robin by rfid_reader_task
+static const rc522_config_t reader_configs[] = RC522_READERS;
+#define READER_COUNT (sizeof(reader_configs) / sizeof(reader_configs[0]))
+
+typedef struct {
+    rc522_t dev;
+    rfid_sched_t sched;
+    int64_t next_ms;         // uptime at which this reader is next due
+    int64_t last_health_ms;
+    char last_uid[21];       // debounce
+    int64_t last_uid_ms;
+} reader_t;
+
+static reader_t readers[READER_COUNT];
+
+// Boot is coordinated through an event group: the reader and display come up
+// while WiFi associates, and only the uplink task waits for an IP.
+#define WIFI_CONNECTED_BIT         (1 << 0)
+#define READER_READY_BIT           (1 << 1)
+#define DISPLAY_READY_BIT          (1 << 2)
+// Set by wifi_event_handler for uplink_task, which shows the status and saves
+// the AP, so the default event loop never waits on the display or on flash.
+#define WIFI_SHOW_CONNECTING_BIT   (1 << 3)
+#define WIFI_SHOW_RECONNECTING_BIT (1 << 4)
+#define WIFI_GOT_IP_BIT            (1 << 5)
+#define WIFI_STATUS_BITS           (WIFI_SHOW_CONNECTING_BIT | WIFI_SHOW_RECONNECTING_BIT | WIFI_GOT_IP_BIT)
+static EventGroupHandle_t app_events = NULL;
+
+// Scans waiting for the uplink task; accepted before WiFi has an IP.
+#define SCAN_QUEUE_LEN             32
+
+typedef struct {
+    char uid[21];
+    char gate_id[16];
+    char event_id[37];
+    uint32_t seq;
+    uint32_t seq_epoch;   // epoch seq was taken under; it changes if NVS fails
+    int64_t scanned_at_ms; // the event's ts, formatted once SNTP has set the clock
+    bool display_pending; // name unknown at scan time; show it once looked up
+} scan_event_t;
+
+static QueueHandle_t scan_queue = NULL;
+
+// Only show a looked-up name if the student is probably still at the reader.
+#define SCAN_DISPLAY_MAX_AGE_MS    3000
+
+// Milliseconds since boot at which each stage became ready (0 = not yet).
+typedef struct {
+    int64_t display_ms;
+    int64_t reader_ms;
+    int64_t ip_ms;
+    int64_t first_scan_ms;
+} boot_metrics_t;
+
+static boot_metrics_t boot_metrics;
+
+// WiFi reconnect: retries run from an esp_timer so the event loop never sleeps.
+#define WIFI_BACKOFF_MIN_MS        250
+#define WIFI_BACKOFF_MAX_MS        8000
+#define WIFI_NVS_NAMESPACE         "wifi"
+#define WIFI_NVS_KEY_AP            "ap"
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+// wifi_ap_cache belongs to the event handler; wifi_ap_saved is what NVS
+// holds and belongs to uplink_task.
+static wifi_ap_cache_t wifi_ap_cache;
+static bool wifi_ap_cache_valid = false;
+static wifi_ap_cache_t wifi_ap_saved;
+static esp_ip4_addr_t wifi_ip; // written before WIFI_GOT_IP_BIT is set
+static bool wifi_attempt_cached = false;
+static uint32_t wifi_backoff_ms = WIFI_BACKOFF_MIN_MS;
+static esp_timer_handle_t wifi_retry_timer = NULL;
 
 static bool oled_ready = false;
 
+// Event sequence numbers, rising across reboots so the gateway can drop
+// retransmits in memory and spot events that arrive out of order. NVS holds
+// the end of the block of EVENT_SEQ_BLOCK numbers being handed out, so it is
+// written once per block rather than per tap; a reboot skips the rest of the
+// block, which the gateway sees as a gap. The epoch is random per NVS
+// lifetime, so an erased device starts a new sequence instead of looking
+// like a replay. Only the reader task takes numbers or reads the epoch; each
+// scan carries the epoch its number was taken under.
+#define EVENT_SEQ_NVS_NAMESPACE    "evseq"
+#define EVENT_SEQ_NVS_KEY_NEXT     "next"
+#define EVENT_SEQ_NVS_KEY_EPOCH    "epoch"
+#define EVENT_SEQ_BLOCK            64
+
+static nvs_handle_t event_seq_nvs;
+static bool event_seq_persisted = false;
+static uint32_t event_seq_epoch = 0;
+static uint32_t event_seq_next = 1;
+static uint32_t event_seq_reserved = 1; // numbers below this are covered by NVS
+
 #define RFID_CACHE_SIZE 16
 
 typedef struct {
     bool used;
+    bool unregistered;  // admin API answered 404; cleared when the filter changes
     char uid[21];
     char name[64];
     char next_event[6]; // "entry" or "exit"
 } rfid_cache_entry_t;
 
 static rfid_cache_entry_t rfid_cache[RFID_CACHE_SIZE];
+// The reader task reads the cache and the UID filter, the uplink task fills them.
+static SemaphoreHandle_t cache_lock = NULL;
+
+// Registered-UID filter; uid_filter.bits points into uid_filter_bufs[uid_filter_active].
+// The other buffer receives downloads, so a refresh never allocates.
+#define UID_FILTER_NVS_NAMESPACE   "uidf"
+#define UID_FILTER_NVS_KEY_BITS    "bits"
+#define UID_FILTER_NVS_KEY_ETAG    "etag"
+
+static uint8_t uid_filter_bufs[2][UID_FILTER_MAX_BYTES];
+static int uid_filter_active = -1;
+static uid_filter_t uid_filter;
+static bool uid_filter_loaded = false;
+static char uid_filter_etag[48];
+
+// Taps by unregistered cards since the last summary was sent.
+typedef struct {
+    char uid[21];
+    uint32_t count;
+    int64_t first_ms; // uptime, like scanned_at_ms
+    int64_t last_ms;
+} unknown_card_t;
+
+static unknown_card_t unknown_cards[UNKNOWN_SUMMARY_SLOTS];
+static size_t unknown_card_count = 0;
+static uint32_t unknown_cards_dropped = 0;
+static SemaphoreHandle_t unknown_lock = NULL;
+// Both tasks draw on the display.
+static SemaphoreHandle_t oled_lock = NULL;
 
 static void oled_show_message(const char *line1, const char *line2) {
     if (!oled_ready) {
         return;
     }
-    ssd1306_clear();
+    xSemaphoreTake(oled_lock, portMAX_DELAY);
+    ssd1306_fb_clear();
     if (line1) {
-        ssd1306_draw_text(0, 0, line1);
+        ssd1306_fb_text(0, 0, 1, line1);
     }
     if (line2) {
-        ssd1306_draw_text(2, 0, line2);
+        ssd1306_fb_text(2, 0, 1, line2);
     }
+    ssd1306_flush();
+    xSemaphoreGive(oled_lock);
 }
 
+// ENTRY/EXIT at 3x on pages 0-2, the name word-wrapped over pages 3-6 at 2x
+// (two lines of 10) or, if it does not fit, at 1x (four lines of 21), and
+// the greeting on page 7. Sent as one I2C write.
 static void oled_show_event(const char *name, bool is_entry) {
     if (!oled_ready) {
         return;
     }
-    char line1[22];
-    snprintf(line1, sizeof(line1), "%s: %s", is_entry ? "ENTRY" : "EXIT", name);
-    char line2[18];
-    snprintf(line2, sizeof(line2), "%s", is_entry ? "Welcome :D" : "Bye Bye :(");
-    ssd1306_clear();
-    ssd1306_draw_text(0, 0, line1);
-    ssd1306_draw_text(2, 0, line2);
+    xSemaphoreTake(oled_lock, portMAX_DELAY);
+    ssd1306_fb_clear();
+    ssd1306_fb_text_centered(0, 3, is_entry ? "ENTRY" : "EXIT");
+    ssd1306_fb_text_wrapped(3, 4, ssd1306_text_fits(4, 2, name) ? 2 : 1, name);
+    ssd1306_fb_text_centered(7, 1, is_entry ? "Welcome :D" : "Bye Bye :(");
+    ssd1306_flush();
+    xSemaphoreGive(oled_lock);
 }
 
-static rfid_cache_entry_t* rfid_cache_get(const char *uid) {
+// Caller holds cache_lock.
+static rfid_cache_entry_t* rfid_cache_find(const char *uid) {
     for (int i = 0; i < RFID_CACHE_SIZE; i++) {
         if (rfid_cache[i].used && strcmp(rfid_cache[i].uid, uid) == 0) {
             return &rfid_cache[i];
         }
     }
+    return NULL;
+}
+
+// Caller holds cache_lock.
+static rfid_cache_entry_t* rfid_cache_get(const char *uid) {
+    rfid_cache_entry_t *found = rfid_cache_find(uid);
+    if (found) {
+        return found;
+    }
     for (int i = 0; i < RFID_CACHE_SIZE; i++) {
         if (!rfid_cache[i].used) {
             rfid_cache[i].used = true;
+            rfid_cache[i].unregistered = false;
             strncpy(rfid_cache[i].uid, uid, sizeof(rfid_cache[i].uid) - 1);
             rfid_cache[i].uid[sizeof(rfid_cache[i].uid) - 1] = '\0';
             rfid_cache[i].name[0] = '\0';
@@ -122,6 +232,7 @@ static rfid_cache_entry_t* rfid_cache_get(const char *uid) {
     }
     // overwrite first entry if cache is full
     rfid_cache[0].used = true;
+    rfid_cache[0].unregistered = false;
     strncpy(rfid_cache[0].uid, uid, sizeof(rfid_cache[0].uid) - 1);
     rfid_cache[0].uid[sizeof(rfid_cache[0].uid) - 1] = '\0';
     rfid_cache[0].name[0] = '\0';
@@ -144,58 +255,6 @@ static bool json_extract_string(const char *json, const char *key, char *out, si
     return true;
 }
 
-static esp_err_t fetch_student_info(const char *uid, rfid_cache_entry_t *entry) {
-    char url[256];
-    snprintf(url, sizeof(url), ADMIN_API_URL "/students/by-rfid/%s", uid);
-    esp_http_client_config_t cfg = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
-        .timeout_ms = 3000,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&cfg);
-    if (!client) {
-        return ESP_FAIL;
-    }
-
-    esp_err_t err = esp_http_client_perform(client);
-    if (err != ESP_OK) {
-        esp_http_client_cleanup(client);
-        return err;
-    }
-
-    int status = esp_http_client_get_status_code(client);
-    if (status != 200) {
-        esp_http_client_cleanup(client);
-        return ESP_FAIL;
-    }
-
-    char response[256];
-    int read_len = esp_http_client_read_response(client, response, sizeof(response) - 1);
-    if (read_len <= 0) {
-        esp_http_client_cleanup(client);
-        return ESP_FAIL;
-    }
-    response[read_len] = '\0';
-
-    char name[64];
-    if (!json_extract_string(response, "name", name, sizeof(name))) {
-        snprintf(name, sizeof(name), "%s", uid);
-    }
-    strncpy(entry->name, name, sizeof(entry->name) - 1);
-    entry->name[sizeof(entry->name) - 1] = '\0';
-
-    char next_event[6];
-    if (json_extract_string(response, "next_event_type", next_event, sizeof(next_event))) {
-        strncpy(entry->next_event, next_event, sizeof(entry->next_event) - 1);
-        entry->next_event[sizeof(entry->next_event) - 1] = '\0';
-    } else {
-        strcpy(entry->next_event, "entry");
-    }
-
-    esp_http_client_cleanup(client);
-    return ESP_OK;
-}
-
 static void init_oled_display(void) {
     if (oled_ready) {
         return;
@@ -215,32 +274,151 @@ static void init_oled_display(void) {
     } else {
         ESP_LOGW(TAG, "OLED init failed");
     }
+    boot_metrics.display_ms = esp_timer_get_time() / 1000;
+    xEventGroupSetBits(app_events, DISPLAY_READY_BIT);
+    ESP_LOGI(TAG, "Boot: display ready at %lld ms", (long long)boot_metrics.display_ms);
+}
+
+static void log_boot_metrics(void) {
+    ESP_LOGI(TAG, "Boot metrics: display=%lld ms reader=%lld ms ip=%lld ms first_scan=%lld ms",
+             (long long)boot_metrics.display_ms, (long long)boot_metrics.reader_ms,
+             (long long)boot_metrics.ip_ms, (long long)boot_metrics.first_scan_ms);
+}
+
+static bool wifi_connected(void) {
+    return (xEventGroupGetBits(app_events) & WIFI_CONNECTED_BIT) != 0;
+}
+
+static void wifi_load_ap_cache(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(wifi_ap_cache);
+    wifi_ap_cache_valid = nvs_get_blob(nvs, WIFI_NVS_KEY_AP, &wifi_ap_cache, &len) == ESP_OK &&
+                          len == sizeof(wifi_ap_cache) && wifi_ap_cache.channel != 0;
+    nvs_close(nvs);
+    if (wifi_ap_cache_valid) {
+        wifi_ap_saved = wifi_ap_cache;
+    }
+}
+
+// The AP we are associated with, or false if there is none.
+static bool wifi_current_ap(wifi_ap_cache_t *out) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return false;
+    }
+    memcpy(out->bssid, ap.bssid, sizeof(out->bssid));
+    out->channel = ap.primary;
+    return true;
+}
+
+// Remember the AP we associated with so the next connect can skip the scan.
+// Runs in the event handler; the flash copy is written by wifi_save_ap_cache.
+static void wifi_remember_ap(void) {
+    wifi_ap_cache_t ap;
+    if (wifi_current_ap(&ap)) {
+        wifi_ap_cache = ap;
+        wifi_ap_cache_valid = true;
+    }
+}
+
+// Runs on uplink_task: an NVS commit can stall for a flash erase.
+static void wifi_save_ap_cache(void) {
+    wifi_ap_cache_t ap;
+    if (!wifi_current_ap(&ap)) {
+        return;
+    }
+    if (wifi_ap_saved.channel == ap.channel &&
+        memcmp(wifi_ap_saved.bssid, ap.bssid, sizeof(ap.bssid)) == 0) {
+        return; // unchanged; spare the flash a write
+    }
+    wifi_ap_saved = ap;
+
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(nvs, WIFI_NVS_KEY_AP, &ap, sizeof(ap)) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+// Point the next esp_wifi_connect() at the cached AP, or at a full scan.
+static void wifi_apply_config(bool use_cache) {
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = WIFI_SSID,
+            .password = WIFI_PASSWORD,
+        },
+    };
+    wifi_attempt_cached = use_cache && wifi_ap_cache_valid;
+    if (wifi_attempt_cached) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, wifi_ap_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = wifi_ap_cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+
+static void wifi_retry_cb(void *arg) {
+    esp_wifi_connect();
 }
 
-// WiFi event handler
+// WiFi event handler. It runs on the default event loop, so it only logs,
+// schedules retries and sets bits; uplink_wifi_status() does the rest.
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                             int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
-        ESP_LOGI(TAG, "WiFi connecting to: %s", WIFI_SSID);
-        oled_show_message("WiFi", "Connecting...");
+        ESP_LOGI(TAG, "WiFi connecting to: %s%s", WIFI_SSID, wifi_attempt_cached ? " (cached AP)" : "");
+        xEventGroupSetBits(app_events, WIFI_SHOW_CONNECTING_BIT);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*) event_data;
-        ESP_LOGW(TAG, "WiFi disconnected (reason: %d), retrying...", disconnected->reason);
-        vTaskDelay(pdMS_TO_TICKS(2000));
-        esp_wifi_connect();
-        oled_show_message("WiFi", "Reconnecting...");
+        bool was_connected = wifi_connected();
+        xEventGroupClearBits(app_events, WIFI_CONNECTED_BIT | WIFI_GOT_IP_BIT);
+
+        // A link that just dropped retries the same AP immediately; a failed
+        // cached attempt falls back to a full scan; repeated failures back off.
+        uint32_t retry_ms = WIFI_BACKOFF_MIN_MS;
+        if (was_connected) {
+            wifi_apply_config(true);
+            wifi_backoff_ms = WIFI_BACKOFF_MIN_MS;
+        } else if (wifi_attempt_cached) {
+            wifi_apply_config(false);
+        } else {
+            retry_ms = wifi_backoff_ms;
+            wifi_backoff_ms = wifi_backoff_ms * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : wifi_backoff_ms * 2;
+        }
+        ESP_LOGW(TAG, "WiFi disconnected (reason: %d), retrying in %" PRIu32 " ms%s",
+                 disconnected->reason, retry_ms, wifi_attempt_cached ? " (cached AP)" : "");
+        esp_timer_stop(wifi_retry_timer);
+        esp_timer_start_once(wifi_retry_timer, (uint64_t)retry_ms * 1000);
+        if (was_connected) {
+            xEventGroupSetBits(app_events, WIFI_SHOW_RECONNECTING_BIT);
+        }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "WiFi connected! IP: " IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "Gateway URL: %s", GATEWAY_URL);
-        char ip_line[32];
-        snprintf(ip_line, sizeof(ip_line), "IP: " IPSTR, IP2STR(&event->ip_info.ip));
-        oled_show_message("WiFi Connected", ip_line);
+        wifi_backoff_ms = WIFI_BACKOFF_MIN_MS;
+        wifi_remember_ap();
+        if (boot_metrics.ip_ms == 0) {
+            boot_metrics.ip_ms = esp_timer_get_time() / 1000;
+            ESP_LOGI(TAG, "Boot: IP assigned at %lld ms", (long long)boot_metrics.ip_ms);
+        }
+        wifi_ip = event->ip_info.ip;
+        xEventGroupClearBits(app_events, WIFI_SHOW_RECONNECTING_BIT);
+        xEventGroupSetBits(app_events, WIFI_CONNECTED_BIT | WIFI_GOT_IP_BIT);
     }
 }
 
-// Initialize WiFi (unchanged from previous implementation)
+// Initialize WiFi; association completes in the background.
 static void wifi_init(void) {
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -249,27 +427,41 @@ static void wifi_init(void) {
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
+    const esp_timer_create_args_t retry_args = {
+        .callback = wifi_retry_cb,
+        .name = "wifi_retry",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&retry_args, &wifi_retry_timer));
+
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
 
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASSWORD,
-        },
-    };
+    wifi_load_ap_cache();
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    wifi_apply_config(true);
     ESP_ERROR_CHECK(esp_wifi_start());
     ESP_LOGI(TAG, "WiFi initialized");
 }
 
-// Get current timestamp in RFC3339 format
-static void get_rfc3339_timestamp(char* buffer, size_t len) {
+static int64_t uptime_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+// True once SNTP has set the clock; until then it reads 1970.
+static bool clock_synced(void) {
+    return time(NULL) >= 1577836800; // 2020-01-01
+}
+
+// RFC3339 timestamp of an instant recorded as uptime. Scans are stamped with
+// uptime and formatted here at send time, so taps made before SNTP answered
+// (at boot or offline) still get their real time. Needs clock_synced().
+static void format_uptime_ts(int64_t at_ms, char* buffer, size_t len) {
     struct timeval tv;
     gettimeofday(&tv, NULL);
+    int64_t ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - (uptime_ms() - at_ms);
+    time_t sec = (time_t)(ms / 1000);
     struct tm timeinfo;
-    localtime_r(&tv.tv_sec, &timeinfo);
+    gmtime_r(&sec, &timeinfo);
 
     snprintf(buffer, len, "%04d-%02d-%02dT%02d:%02d:%02d.%03" PRId32 "Z",
              timeinfo.tm_year + 1900,
@@ -278,7 +470,7 @@ static void get_rfc3339_timestamp(char* buffer, size_t len) {
              timeinfo.tm_hour,
              timeinfo.tm_min,
              timeinfo.tm_sec,
-             (int32_t)(tv.tv_usec / 1000));
+             (int32_t)(ms % 1000));
 }
 
 // Generate UUID v4 (simplified)
@@ -296,29 +488,107 @@ static void generate_uuid(char* uuid) {
              random_values[3] & 0xFFFF);
 }
 
-// HTTP event handler
-esp_err_t http_event_handler(esp_http_client_event_t *evt) {
-    switch(evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-            break;
+// HTTP clients are created once and reused, so scans go out over the open
+// (TLS) connection with the client's buffers instead of allocating a client
+// per request. esp_http_client_set_url() allocates, so the per-scan lookup
+// has its own client on a fixed URL with the UID in the body; only
+// housekeeping switches URLs. All are used only by uplink_task.
+static esp_http_client_handle_t gateway_http = NULL; // /api/events, /api/rfid/unknown-summary
+static esp_http_client_handle_t admin_http = NULL;   // /rfid/filter
+static esp_http_client_handle_t lookup_http = NULL;  // /students/lookup
+
+// Each client keeps its TLS session (save_client_session), so when the server
+// closes an idle connection the next request resumes the session instead of
+// repeating ECDHE and certificate verification. esp_http_client does not say
+// whether a server accepted the session, so a connection set up within
+// TLS_RESUMED_MAX_MS on a client that has a session is counted as resumed;
+// a full handshake takes well over that on an ESP32.
+#define TLS_RESUMED_MAX_MS         400
+
+typedef struct {
+    const char *name;
+    bool https;
+    bool has_session;        // a handshake completed, so the next can resume
+    int64_t perform_start_us;
+    uint32_t full, resumed;
+    uint64_t full_ms, resumed_ms;
+} http_tls_stats_t;
+
+static http_tls_stats_t gateway_tls = { .name = "gateway" };
+static http_tls_stats_t admin_tls = { .name = "admin" };
+static http_tls_stats_t lookup_tls = { .name = "lookup" };
+
+static http_tls_stats_t *http_tls_stats(esp_http_client_handle_t client) {
+    if (client == gateway_http) {
+        return &gateway_tls;
+    }
+    return client == lookup_http ? &lookup_tls : &admin_tls;
+}
+
+// Count one new connection; called on HTTP_EVENT_ON_CONNECTED, i.e. after
+// the TCP connect and TLS handshake.
+static void http_tls_connected(esp_http_client_handle_t client) {
+    http_tls_stats_t *t = http_tls_stats(client);
+    if (!t->https) {
+        return;
+    }
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - t->perform_start_us) / 1000);
+    if (t->has_session && ms < TLS_RESUMED_MAX_MS) {
+        t->resumed++;
+        t->resumed_ms += ms;
+    } else {
+        t->full++;
+        t->full_ms += ms;
+    }
+    t->has_session = true;
+    ESP_LOGD(TAG, "TLS [%s]: connected in %" PRIu32 " ms", t->name, ms);
+}
+
+static void log_tls_stats(const http_tls_stats_t *t) {
+    if (!t->https) {
+        return;
+    }
+    ESP_LOGI(TAG, "TLS [%s]: %" PRIu32 " full handshakes (avg %" PRIu32 " ms), %" PRIu32 " resumed (avg %" PRIu32 " ms)",
+             t->name, t->full, t->full ? (uint32_t)(t->full_ms / t->full) : 0,
+             t->resumed, t->resumed ? (uint32_t)(t->resumed_ms / t->resumed) : 0);
+}
+
+// Where the event handler puts a response body, ETag and Retry-After.
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool truncated;
+    char etag[sizeof(uid_filter_etag)];
+    uint32_t retry_after_s; // delta-seconds form only; 0 if absent
+} http_sink_t;
+
+static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
+    http_sink_t *sink = evt->user_data;
+    switch (evt->event_id) {
         case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
+            http_tls_connected(evt->client);
             break;
         case HTTP_EVENT_ON_HEADER:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+            if (sink && strcasecmp(evt->header_key, "ETag") == 0) {
+                snprintf(sink->etag, sizeof(sink->etag), "%s", evt->header_value);
+            } else if (sink && strcasecmp(evt->header_key, "Retry-After") == 0) {
+                sink->retry_after_s = (uint32_t)strtoul(evt->header_value, NULL, 10);
+            }
             break;
         case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
+            if (sink && sink->buf) {
+                size_t n = (size_t)evt->data_len;
+                if (n > sink->cap - sink->len) {
+                    n = sink->cap - sink->len;
+                    sink->truncated = true;
+                }
+                memcpy(sink->buf + sink->len, evt->data, n);
+                sink->len += n;
+            }
             break;
         case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
+            ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
             break;
         default:
             break;
@@ -326,401 +596,911 @@ esp_err_t http_event_handler(esp_http_client_event_t *evt) {
     return ESP_OK;
 }
 
-// Send event to gateway
-static void send_event_to_gateway(const char* rfid_uid) {
-    int64_t now_ms = esp_timer_get_time() / 1000;
-
-    if (now_ms - last_scan_time < DEBOUNCE_MS) {
-        ESP_LOGW(TAG, "Ignoring duplicate scan (debounce)");
-        return;
-    }
-    last_scan_time = now_ms;
-
-    char event_id[37];
-    char timestamp[30];
-    generate_uuid(event_id);
-    get_rfc3339_timestamp(timestamp, sizeof(timestamp));
-
-    char json_string[256];
-    snprintf(json_string, sizeof(json_string),
-        "{\"event_id\":\"%s\",\"device_id\":\"%s\",\"rfid_uid\":\"%s\",\"ts\":\"%s\"}",
-        event_id, DEVICE_ID, rfid_uid, timestamp);
-    ESP_LOGI(TAG, "Sending event: %s", json_string);
-
-    esp_http_client_config_t config = {
+static void http_clients_init(void) {
+    esp_http_client_config_t gateway_cfg = {
         .url = GATEWAY_URL "/api/events",
-        .event_handler = http_event_handler,
         .method = HTTP_METHOD_POST,
+        .timeout_ms = 5000,
+        .event_handler = http_event_handler,
+        .keep_alive_enable = true,
+        .save_client_session = true,
     };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    gateway_http = esp_http_client_init(&gateway_cfg);
+    gateway_tls.https = strncmp(GATEWAY_URL, "https:", 6) == 0;
+    esp_http_client_set_header(gateway_http, "Content-Type", "application/json");
+    esp_http_client_set_header(gateway_http, "X-Device-Token", DEVICE_TOKEN);
 
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "X-Device-Token", DEVICE_TOKEN);
+    esp_http_client_config_t admin_cfg = {
+        .url = ADMIN_API_URL "/rfid/filter",
+        .method = HTTP_METHOD_GET,
+        .timeout_ms = 3000,
+        .event_handler = http_event_handler,
+        .keep_alive_enable = true,
+        .save_client_session = true,
+    };
+    admin_http = esp_http_client_init(&admin_cfg);
+    admin_tls.https = strncmp(ADMIN_API_URL, "https:", 6) == 0;
 
-    esp_http_client_set_post_field(client, json_string, strlen(json_string));
+    esp_http_client_config_t lookup_cfg = {
+        .url = ADMIN_API_URL "/students/lookup",
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = 3000,
+        .event_handler = http_event_handler,
+        .keep_alive_enable = true,
+        .save_client_session = true,
+    };
+    lookup_http = esp_http_client_init(&lookup_cfg);
+    lookup_tls.https = admin_tls.https;
+    esp_http_client_set_header(lookup_http, "Content-Type", "application/json");
+}
 
+// Perform a request on a persistent client. A connection the server closed
+// while idle fails on first use, so a transport error is retried once on a
+// fresh connection. Returns the HTTP status, or -1 on a transport error.
+static int http_request(esp_http_client_handle_t client, const char *url, http_sink_t *sink) {
+    if (url) {
+        esp_http_client_set_url(client, url);
+    }
+    esp_http_client_set_user_data(client, sink);
+    http_tls_stats_t *tls = http_tls_stats(client);
+    tls->perform_start_us = esp_timer_get_time();
     esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
-
-    if (err == ESP_OK && (status_code == 201 || status_code == 202)) {
-        ESP_LOGI(TAG, "Event sent successfully (status: %d)", status_code);
-    } else {
-        ESP_LOGE(TAG, "Failed to send event: %s, status: %d", esp_err_to_name(err), status_code);
+    if (err != ESP_OK) {
+        esp_http_client_close(client);
+        if (sink) {
+            sink->len = 0;
+            sink->truncated = false;
+        }
+        tls->perform_start_us = esp_timer_get_time();
+        err = esp_http_client_perform(client);
     }
-
-    esp_http_client_cleanup(client);
+    esp_http_client_set_user_data(client, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        esp_http_client_close(client);
+        return -1;
+    }
+    return esp_http_client_get_status_code(client);
 }
 
-// Low-level SPI helpers mapped from the Lua reference implementation
-static esp_err_t rc522_write_reg(uint8_t reg, uint8_t value) {
-    if (!rc522_spi) {
-        return ESP_ERR_INVALID_STATE;
-    }
+static esp_err_t fetch_student_info(const char *uid, rfid_cache_entry_t *entry) {
+    // Static: lookup_http keeps pointing at it between requests.
+    static char body[48];
+    snprintf(body, sizeof(body), "{\"rfid_uid\":\"%s\"}", uid);
+    char response[256];
+    http_sink_t sink = { .buf = (uint8_t *)response, .cap = sizeof(response) - 1 };
 
-    spi_transaction_t t = {
-        .flags = SPI_TRANS_USE_TXDATA,
-        .length = 16,
-    };
-    t.tx_data[0] = (uint8_t)((reg << 1) & 0x7E);
-    t.tx_data[1] = value;
-    return spi_device_transmit(rc522_spi, &t);
-}
+    esp_http_client_set_post_field(lookup_http, body, strlen(body));
+    int status = http_request(lookup_http, NULL, &sink);
+    if (status < 0) {
+        return ESP_FAIL;
+    }
+    if (status != 200) {
+        return status == 404 ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+    }
+    if (sink.len == 0) {
+        return ESP_FAIL;
+    }
+    response[sink.len] = '\0';
 
-static esp_err_t rc522_read_reg(uint8_t reg, uint8_t *value) {
-    if (!rc522_spi || !value) {
-        return ESP_ERR_INVALID_STATE;
+    char name[64];
+    if (!json_extract_string(response, "name", name, sizeof(name))) {
+        snprintf(name, sizeof(name), "%s", uid);
     }
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
 
-    spi_transaction_t t = {
-        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
-        .length = 16,
-    };
-    t.tx_data[0] = (uint8_t)(((reg << 1) & 0x7E) | 0x80);
-    t.tx_data[1] = 0x00;
-    esp_err_t ret = spi_device_transmit(rc522_spi, &t);
-    if (ret == ESP_OK) {
-        *value = t.rx_data[1];
+    char next_event[6];
+    if (json_extract_string(response, "next_event_type", next_event, sizeof(next_event))) {
+        strncpy(entry->next_event, next_event, sizeof(entry->next_event) - 1);
+        entry->next_event[sizeof(entry->next_event) - 1] = '\0';
+    } else {
+        strcpy(entry->next_event, "entry");
     }
-    return ret;
+    return ESP_OK;
 }
 
-static esp_err_t rc522_set_bitmask(uint8_t reg, uint8_t mask) {
-    uint8_t value;
-    ESP_ERROR_CHECK(rc522_read_reg(reg, &value));
-    return rc522_write_reg(reg, value | mask);
+// The handle stays open so taking a number never opens NVS on the scan path.
+static void event_seq_init(void) {
+    if (nvs_open(EVENT_SEQ_NVS_NAMESPACE, NVS_READWRITE, &event_seq_nvs) != ESP_OK) {
+        event_seq_epoch = esp_random() | 1;
+        ESP_LOGE(TAG, "Event sequence not persisted; using epoch %08" PRIx32 " for this boot", event_seq_epoch);
+        return;
+    }
+    event_seq_persisted = true;
+    uint32_t next = 1;
+    if (nvs_get_u32(event_seq_nvs, EVENT_SEQ_NVS_KEY_EPOCH, &event_seq_epoch) != ESP_OK || event_seq_epoch == 0) {
+        event_seq_epoch = esp_random() | 1;
+        if (nvs_set_u32(event_seq_nvs, EVENT_SEQ_NVS_KEY_EPOCH, event_seq_epoch) != ESP_OK ||
+            nvs_commit(event_seq_nvs) != ESP_OK) {
+            event_seq_persisted = false;
+        }
+    } else if (nvs_get_u32(event_seq_nvs, EVENT_SEQ_NVS_KEY_NEXT, &next) != ESP_OK || next == 0) {
+        next = 1;
+    }
+    event_seq_next = event_seq_reserved = next;
+    ESP_LOGI(TAG, "Event sequence epoch %08" PRIx32 ", next %" PRIu32, event_seq_epoch, event_seq_next);
 }
 
-static esp_err_t rc522_clear_bitmask(uint8_t reg, uint8_t mask) {
-    uint8_t value;
-    ESP_ERROR_CHECK(rc522_read_reg(reg, &value));
-    return rc522_write_reg(reg, value & (uint8_t)(~mask));
+static uint32_t event_seq_take(void) {
+    if (event_seq_next >= event_seq_reserved && event_seq_persisted) {
+        uint32_t reserve = event_seq_next + EVENT_SEQ_BLOCK;
+        if (nvs_set_u32(event_seq_nvs, EVENT_SEQ_NVS_KEY_NEXT, reserve) == ESP_OK &&
+            nvs_commit(event_seq_nvs) == ESP_OK) {
+            event_seq_reserved = reserve;
+        } else {
+            // Numbers past the stored block could be handed out again after
+            // a reboot; a fresh epoch keeps them apart from those.
+            event_seq_persisted = false;
+            event_seq_epoch = esp_random() | 1;
+            ESP_LOGE(TAG, "Could not persist event sequence; epoch %08" PRIx32 " until reboot", event_seq_epoch);
+        }
+    }
+    return event_seq_next++;
 }
 
-static esp_err_t rc522_calculate_crc(const uint8_t *data, size_t length, uint8_t *result) {
-    ESP_ERROR_CHECK(rc522_clear_bitmask(RC522_REG_DIV_IRQ, 0x04));
-    ESP_ERROR_CHECK(rc522_set_bitmask(RC522_REG_FIFO_LEVEL, 0x80));
+typedef enum {
+    SEND_OK,       // stored or buffered by the gateway
+    SEND_REJECTED, // the gateway will never take it (4xx); drop it
+    SEND_RETRY,    // overloaded, failing or unreachable; hold it
+} send_result_t;
+
+// Send event to gateway. On SEND_RETRY, *retry_after_ms is the gateway's
+// Retry-After, or 0 if it gave none.
+static send_result_t send_event_to_gateway(const scan_event_t *scan, uint32_t *retry_after_ms) {
+    char ts[30];
+    format_uptime_ts(scan->scanned_at_ms, ts, sizeof(ts));
+    char json_string[320];
+    snprintf(json_string, sizeof(json_string),
+        "{\"event_id\":\"%s\",\"device_id\":\"%s\",\"rfid_uid\":\"%s\",\"gate_id\":\"%s\",\"ts\":\"%s\","
+        "\"seq\":%" PRIu32 ",\"seq_epoch\":%" PRIu32 "}",
+        scan->event_id, DEVICE_ID, scan->uid, scan->gate_id, ts, scan->seq, scan->seq_epoch);
+    ESP_LOGI(TAG, "Sending event: %s", json_string);
 
-    for (size_t i = 0; i < length; i++) {
-        ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_FIFO_DATA, data[i]));
-    }
+    http_sink_t sink = {0};
+    esp_http_client_set_post_field(gateway_http, json_string, strlen(json_string));
+    int status_code = http_request(gateway_http, NULL, &sink);
+    *retry_after_ms = 0;
 
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_COMMAND, RC522_CMD_CALC_CRC));
+    if (status_code == 201 || status_code == 202) {
+        ESP_LOGI(TAG, "Event sent successfully (status: %d)", status_code);
+        return SEND_OK;
+    }
+    if (status_code == 429 || status_code == 503) {
+        *retry_after_ms = sink.retry_after_s * 1000;
+        ESP_LOGW(TAG, "Gateway busy (status: %d, Retry-After: %" PRIu32 "s)", status_code, sink.retry_after_s);
+        return SEND_RETRY;
+    }
+    if (status_code < 0 || status_code >= 500) {
+        ESP_LOGE(TAG, "Failed to send event, status: %d; holding it", status_code);
+        return SEND_RETRY;
+    }
+    ESP_LOGE(TAG, "Gateway rejected event %s, status: %d", scan->event_id, status_code);
+    return SEND_REJECTED;
+}
 
-    int i = 0xFF;
-    uint8_t n = 0;
-    do {
-        ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_DIV_IRQ, &n));
-        i--;
-    } while (i != 0 && !(n & 0x04));
+// The filter buffer not currently installed; only uplink_task (and boot)
+// write to it.
+static uint8_t *uid_filter_spare(void) {
+    return uid_filter_bufs[uid_filter_active == 0 ? 1 : 0];
+}
 
-    if (i == 0) {
-        return ESP_ERR_TIMEOUT;
+// Swap in a validated filter held in uid_filter_spare(). Negative cache
+// entries the new filter no longer rejects are dropped so those cards get
+// looked up.
+static void uid_filter_install(const uid_filter_t *f, const char *etag) {
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    uid_filter_active = uid_filter_active == 0 ? 1 : 0;
+    uid_filter = *f;
+    uid_filter_loaded = true;
+    snprintf(uid_filter_etag, sizeof(uid_filter_etag), "%s", etag);
+    for (int i = 0; i < RFID_CACHE_SIZE; i++) {
+        if (rfid_cache[i].used && rfid_cache[i].unregistered &&
+            uid_filter_maybe_contains(&uid_filter, rfid_cache[i].uid)) {
+            rfid_cache[i].used = false;
+        }
     }
+    xSemaphoreGive(cache_lock);
+}
 
-    ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_CRC_RESULT_L, &result[0]));
-    ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_CRC_RESULT_H, &result[1]));
-    return ESP_OK;
+// Load the last downloaded filter so unknown cards are rejected offline too.
+static void uid_filter_load(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(UID_FILTER_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    uint8_t *buf = uid_filter_spare();
+    size_t len = UID_FILTER_MAX_BYTES;
+    char etag[sizeof(uid_filter_etag)] = {0};
+    size_t etag_len = sizeof(etag);
+    uid_filter_t f;
+    if (nvs_get_blob(nvs, UID_FILTER_NVS_KEY_BITS, buf, &len) == ESP_OK && uid_filter_parse(&f, buf, len)) {
+        if (nvs_get_str(nvs, UID_FILTER_NVS_KEY_ETAG, etag, &etag_len) != ESP_OK) {
+            etag[0] = '\0';
+        }
+        uid_filter_install(&f, etag);
+        ESP_LOGI(TAG, "UID filter loaded from NVS: %" PRIu32 " cards, %u bytes", f.n, (unsigned)len);
+    }
+    nvs_close(nvs);
 }
 
-static esp_err_t rc522_transceive(const uint8_t *send_data,
-                                  size_t send_len,
-                                  uint8_t *back_data,
-                                  size_t *back_bits) {
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_COMM_IE, 0x77 | 0x80));
-    ESP_ERROR_CHECK(rc522_clear_bitmask(RC522_REG_COMM_IRQ, 0x80));
-    ESP_ERROR_CHECK(rc522_set_bitmask(RC522_REG_FIFO_LEVEL, 0x80));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_COMMAND, RC522_CMD_IDLE));
+static void uid_filter_save(const uint8_t *buf, size_t len, const char *etag) {
+    nvs_handle_t nvs;
+    if (nvs_open(UID_FILTER_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(nvs, UID_FILTER_NVS_KEY_BITS, buf, len) == ESP_OK &&
+        nvs_set_str(nvs, UID_FILTER_NVS_KEY_ETAG, etag) == ESP_OK) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGW(TAG, "UID filter too large for NVS, keeping it in RAM only");
+    }
+    nvs_close(nvs);
+}
 
-    for (size_t i = 0; i < send_len; i++) {
-        ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_FIFO_DATA, send_data[i]));
+// Conditional GET of the registered-UID filter into the spare buffer; a 304
+// costs one round trip. If-None-Match stays set on admin_http between
+// refreshes, so it is only rewritten when the ETag changes.
+static void uid_filter_refresh(void) {
+    static char if_none_match[sizeof(uid_filter_etag)];
+    if (uid_filter_loaded && strcmp(if_none_match, uid_filter_etag) != 0) {
+        snprintf(if_none_match, sizeof(if_none_match), "%s", uid_filter_etag);
+        esp_http_client_set_header(admin_http, "If-None-Match", if_none_match);
     }
 
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_COMMAND, RC522_CMD_TRANSCEIVE));
-    ESP_ERROR_CHECK(rc522_set_bitmask(RC522_REG_BIT_FRAMING, 0x80));
+    http_sink_t sink = { .buf = uid_filter_spare(), .cap = UID_FILTER_MAX_BYTES };
+    int status = http_request(admin_http, ADMIN_API_URL "/rfid/filter", &sink);
+    if (status == 304) {
+        return;
+    }
+    uid_filter_t f;
+    if (status != 200 || sink.truncated || !uid_filter_parse(&f, sink.buf, sink.len)) {
+        ESP_LOGW(TAG, "UID filter fetch failed: status %d, %u bytes%s", status, (unsigned)sink.len,
+                 sink.truncated ? " (over UID_FILTER_MAX_BYTES)" : "");
+        return;
+    }
+    uid_filter_save(sink.buf, sink.len, sink.etag);
+    uid_filter_install(&f, sink.etag);
+    ESP_LOGI(TAG, "UID filter updated: %" PRIu32 " cards, %u bytes, k=%u", f.n, (unsigned)sink.len, f.k);
+}
 
-    int iterations = 2000;
-    uint8_t irq_status = 0;
-    do {
-        ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_COMM_IRQ, &irq_status));
-        iterations--;
-    } while (iterations && !(irq_status & 0x01) && !(irq_status & 0x30));
+// Caller holds unknown_lock.
+static void unknown_card_add(const char *uid, uint32_t count, int64_t first_ms, int64_t last_ms) {
+    for (size_t i = 0; i < unknown_card_count; i++) {
+        unknown_card_t *c = &unknown_cards[i];
+        if (strcmp(c->uid, uid) == 0) {
+            c->count += count;
+            if (first_ms < c->first_ms) {
+                c->first_ms = first_ms;
+            }
+            if (last_ms > c->last_ms) {
+                c->last_ms = last_ms;
+            }
+            return;
+        }
+    }
+    if (unknown_card_count == UNKNOWN_SUMMARY_SLOTS) {
+        unknown_cards_dropped += count;
+        return;
+    }
+    unknown_card_t *c = &unknown_cards[unknown_card_count++];
+    snprintf(c->uid, sizeof(c->uid), "%s", uid);
+    c->count = count;
+    c->first_ms = first_ms;
+    c->last_ms = last_ms;
+}
 
-    ESP_ERROR_CHECK(rc522_clear_bitmask(RC522_REG_BIT_FRAMING, 0x80));
+static void unknown_card_record(const char *uid, int64_t at_ms) {
+    xSemaphoreTake(unknown_lock, portMAX_DELAY);
+    unknown_card_add(uid, 1, at_ms, at_ms);
+    xSemaphoreGive(unknown_lock);
+}
 
-    if (iterations == 0) {
-        return ESP_ERR_TIMEOUT;
+// POST the unknown-card summary to the gateway. Returns true when the gateway
+// reports some of the UIDs as registered, i.e. the filter is stale.
+static bool unknown_summary_flush(void) {
+    static unknown_card_t batch[UNKNOWN_SUMMARY_SLOTS];
+    static char body[96 + UNKNOWN_SUMMARY_SLOTS * 128];
+    static char response[1024];
+
+    xSemaphoreTake(unknown_lock, portMAX_DELAY);
+    size_t count = unknown_card_count;
+    uint32_t dropped = unknown_cards_dropped;
+    memcpy(batch, unknown_cards, count * sizeof(batch[0]));
+    unknown_card_count = 0;
+    unknown_cards_dropped = 0;
+    xSemaphoreGive(unknown_lock);
+    if (count == 0 && dropped == 0) {
+        return false;
     }
 
-    uint8_t error = 0;
-    ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_ERROR, &error));
-    if (error & 0x1B) {
-        return ESP_FAIL;
+    size_t off = snprintf(body, sizeof(body), "{\"dropped\":%" PRIu32 ",\"entries\":[", dropped);
+    for (size_t i = 0; i < count; i++) {
+        char first_ts[30], last_ts[30];
+        format_uptime_ts(batch[i].first_ms, first_ts, sizeof(first_ts));
+        format_uptime_ts(batch[i].last_ms, last_ts, sizeof(last_ts));
+        off += snprintf(body + off, sizeof(body) - off,
+            "%s{\"rfid_uid\":\"%s\",\"count\":%" PRIu32 ",\"first_seen\":\"%s\",\"last_seen\":\"%s\"}",
+            i ? "," : "", batch[i].uid, batch[i].count, first_ts, last_ts);
     }
+    snprintf(body + off, sizeof(body) - off, "]}");
 
-    if (back_data && back_bits) {
-        uint8_t length = 0;
-        uint8_t last_bits = 0;
-        ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_FIFO_LEVEL, &length));
-        ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_CONTROL, &last_bits));
-        last_bits &= 0x07;
-
-        if (last_bits != 0) {
-            *back_bits = (size_t)((length - 1) * 8 + last_bits);
-        } else {
-            *back_bits = (size_t)(length * 8);
-        }
+    http_sink_t sink = { .buf = (uint8_t *)response, .cap = sizeof(response) - 1 };
+    esp_http_client_set_post_field(gateway_http, body, strlen(body));
+    int status = http_request(gateway_http, GATEWAY_URL "/api/rfid/unknown-summary", &sink);
+    esp_http_client_set_url(gateway_http, GATEWAY_URL "/api/events");
 
-        for (uint8_t i = 0; i < length && i < MFRC522_MAX_LEN; i++) {
-            ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_FIFO_DATA, &back_data[i]));
+    if (status != 200) {
+        // Keep the counts for the next attempt.
+        xSemaphoreTake(unknown_lock, portMAX_DELAY);
+        for (size_t i = 0; i < count; i++) {
+            unknown_card_add(batch[i].uid, batch[i].count, batch[i].first_ms, batch[i].last_ms);
         }
+        unknown_cards_dropped += dropped;
+        xSemaphoreGive(unknown_lock);
+        ESP_LOGW(TAG, "Unknown-card summary not sent (%u cards, status %d), will retry", (unsigned)count, status);
+        return false;
     }
+    response[sink.len] = '\0';
+    ESP_LOGI(TAG, "Unknown-card summary sent: %u cards, %" PRIu32 " dropped", (unsigned)count, dropped);
+    return strstr(response, "\"registered\":[\"") != NULL;
+}
 
-    return ESP_OK;
+// vTaskDelay that never rounds a non-zero wait down to zero ticks.
+static void delay_ms(uint32_t ms) {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ticks ? ticks : 1);
 }
 
-static esp_err_t rc522_request(uint8_t req_mode) {
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_BIT_FRAMING, 0x07));
-    uint8_t back_data[MFRC522_MAX_LEN] = {0};
-    size_t back_bits = 0;
-    esp_err_t err = rc522_transceive(&req_mode, 1, back_data, &back_bits);
-    if (err != ESP_OK || back_bits != 0x10) {
-        return ESP_FAIL;
+// Local hour for the polling profiles, or -1 until SNTP has set the clock.
+static int local_hour(void) {
+    if (!clock_synced()) {
+        return -1;
     }
-    return ESP_OK;
+    time_t now = time(NULL);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    return timeinfo.tm_hour;
 }
 
-static esp_err_t rc522_anticoll(uint8_t *serial, size_t *serial_len) {
-    uint8_t command[] = {PICC_ANTICOLL_CL1, 0x20};
-    uint8_t back_data[MFRC522_MAX_LEN] = {0};
-    size_t back_bits = 0;
+// Gates named "entry" or "exit" fix the direction (1 / 0); any other gate toggles (-1).
+static int gate_direction(const char *gate_id) {
+    if (strcasecmp(gate_id, "entry") == 0) {
+        return 1;
+    }
+    if (strcasecmp(gate_id, "exit") == 0) {
+        return 0;
+    }
+    return -1;
+}
 
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_BIT_FRAMING, 0x00));
+// Direction of this scan from the gate or the cached state; advances the cache.
+// Caller holds cache_lock.
+static bool cache_next_direction(rfid_cache_entry_t *entry, const char *gate_id) {
+    int dir = gate_direction(gate_id);
+    bool is_entry = dir >= 0 ? dir == 1 : strcasecmp(entry->next_event, "exit") != 0;
+    strcpy(entry->next_event, is_entry ? "exit" : "entry");
+    return is_entry;
+}
 
-    esp_err_t err = rc522_transceive(command, sizeof(command), back_data, &back_bits);
-    if (err != ESP_OK) {
-        return err;
+// Runs on the reader task: never touches the network.
+static void handle_card(reader_t *reader, const uint8_t *uid, size_t uid_len) {
+    int64_t now = uptime_ms();
+    scan_event_t scan = {0};
+    for (size_t i = 0; i < uid_len && (i * 2 + 1) < sizeof(scan.uid); i++) {
+        snprintf(&scan.uid[i * 2], sizeof(scan.uid) - (i * 2), "%02X", uid[i]);
     }
 
-    if (back_bits != 0x28) {
-        return ESP_FAIL;
+    if (strcmp(scan.uid, reader->last_uid) == 0 && now - reader->last_uid_ms < DEBOUNCE_MS) {
+        ESP_LOGW(TAG, "Ignoring duplicate scan (debounce)");
+        return;
     }
+    strcpy(reader->last_uid, scan.uid);
+    reader->last_uid_ms = now;
+    snprintf(scan.gate_id, sizeof(scan.gate_id), "%s", reader->dev.cfg.gate_id);
 
-    uint8_t check = 0;
-    for (int i = 0; i < 4; i++) {
-        serial[i] = back_data[i];
-        check ^= back_data[i];
+    if (boot_metrics.first_scan_ms == 0) {
+        boot_metrics.first_scan_ms = now;
+        log_boot_metrics();
     }
 
-    if (check != back_data[4]) {
-        return ESP_FAIL;
+    scan.scanned_at_ms = now;
+
+    char name[64] = {0};
+    bool is_entry = true;
+    bool unregistered = false;
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    rfid_cache_entry_t *cache_entry = rfid_cache_find(scan.uid);
+    if (cache_entry && cache_entry->unregistered) {
+        unregistered = true;
+    } else if (cache_entry && cache_entry->name[0] != '\0') {
+        strcpy(name, cache_entry->name);
+        is_entry = cache_next_direction(cache_entry, scan.gate_id);
+    } else if (uid_filter_loaded && !uid_filter_maybe_contains(&uid_filter, scan.uid)) {
+        unregistered = true;
+    }
+    xSemaphoreGive(cache_lock);
+
+    if (unregistered) {
+        // Reported in the next unknown-card summary, not as an event.
+        ESP_LOGI(TAG, "Unregistered card %s (gate %s)", scan.uid, scan.gate_id);
+        oled_show_message("Not registered", scan.uid);
+        unknown_card_record(scan.uid, scan.scanned_at_ms);
+        return;
+    }
+
+    generate_uuid(scan.event_id);
+    scan.seq = event_seq_take();
+    scan.seq_epoch = event_seq_epoch;
+
+    ESP_LOGI(TAG, "@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#");
+    ESP_LOGI(TAG, "RFID CARD DETECTED!");
+    ESP_LOGI(TAG, "UID: %s (gate %s)", scan.uid, scan.gate_id);
+    ESP_LOGI(TAG, "Queued for gateway...");
+    ESP_LOGI(TAG, "@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#");
+
+    if (name[0] != '\0') {
+        oled_show_event(name, is_entry);
+    } else if (wifi_connected()) {
+        scan.display_pending = true;
+        oled_show_message("Card read", "Looking up...");
+    } else {
+        oled_show_message("Card saved", "Will sync later");
     }
 
-    serial[4] = back_data[4];
-    if (serial_len) {
-        *serial_len = 5;
+    if (xQueueSend(scan_queue, &scan, 0) != pdTRUE) {
+        ESP_LOGE(TAG, "Scan queue full, dropping %s", scan.uid);
     }
-    return ESP_OK;
 }
 
-static esp_err_t rc522_halt(void) {
-    uint8_t buffer[4] = {0x50, 0x00, 0x00, 0x00};
-    uint8_t crc[2] = {0};
-    esp_err_t err = rc522_calculate_crc(buffer, 2, crc);
+// Look up a card the reader task had no name for and show it if still relevant.
+// Returns false for an unregistered card, which is summarised instead of sent.
+static bool resolve_and_show(const scan_event_t *scan) {
+    rfid_cache_entry_t fetched = {0};
+    esp_err_t err = fetch_student_info(scan->uid, &fetched);
+    if (err == ESP_ERR_NOT_FOUND) {
+        // A filter false positive (or no filter yet): remember the miss so
+        // re-taps are answered locally.
+        xSemaphoreTake(cache_lock, portMAX_DELAY);
+        rfid_cache_get(scan->uid)->unregistered = true;
+        xSemaphoreGive(cache_lock);
+        if (uptime_ms() - scan->scanned_at_ms < SCAN_DISPLAY_MAX_AGE_MS) {
+            oled_show_message("Not registered", scan->uid);
+        }
+        unknown_card_record(scan->uid, scan->scanned_at_ms);
+        return false;
+    }
     if (err != ESP_OK) {
-        return err;
+        snprintf(fetched.name, sizeof(fetched.name), "%s", scan->uid);
+        strcpy(fetched.next_event, "entry");
+    }
+
+    char name[64];
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    rfid_cache_entry_t *cache_entry = rfid_cache_get(scan->uid);
+    if (cache_entry->name[0] == '\0') {
+        strcpy(cache_entry->name, fetched.name);
+        strcpy(cache_entry->next_event, fetched.next_event);
+    }
+    bool is_entry = cache_next_direction(cache_entry, scan->gate_id);
+    strcpy(name, cache_entry->name);
+    xSemaphoreGive(cache_lock);
+
+    if (uptime_ms() - scan->scanned_at_ms < SCAN_DISPLAY_MAX_AGE_MS) {
+        oled_show_event(name, is_entry);
+    }
+    return true;
+}
+
+// Tasks, queues and locks live in static storage, so after boot the heap only
+// serves WiFi and TLS and days of uptime don't fragment it. Stack sizes are in
+// bytes (StackType_t is a byte on ESP-IDF); log_memory_stats() reports how
+// much of each is used.
+#define RFID_TASK_STACK_SIZE       4096
+#define UPLINK_TASK_STACK_SIZE     8192
+#define STACK_LOW_WATER_BYTES      512
+#define MEMORY_STATS_INTERVAL_MS   (10 * 60 * 1000)
+
+static StaticTask_t rfid_task_tcb;
+static StackType_t rfid_task_stack[RFID_TASK_STACK_SIZE];
+static TaskHandle_t rfid_task_handle = NULL;
+static StaticTask_t uplink_task_tcb;
+static StackType_t uplink_task_stack[UPLINK_TASK_STACK_SIZE];
+static TaskHandle_t uplink_task_handle = NULL;
+static StaticEventGroup_t app_events_buf;
+static StaticQueue_t scan_queue_buf;
+static uint8_t scan_queue_storage[SCAN_QUEUE_LEN * sizeof(scan_event_t)];
+static StaticSemaphore_t cache_lock_buf;
+static StaticSemaphore_t oled_lock_buf;
+static StaticSemaphore_t unknown_lock_buf;
+
+static void log_task_stack(const char *name, TaskHandle_t task, uint32_t size) {
+    if (!task) {
+        return;
+    }
+    uint32_t unused = uxTaskGetStackHighWaterMark(task);
+    if (unused < STACK_LOW_WATER_BYTES) {
+        ESP_LOGW(TAG, "Stack [%s]: peak %" PRIu32 " of %" PRIu32 " bytes, only %" PRIu32 " left",
+                 name, size - unused, size, unused);
+    } else {
+        ESP_LOGI(TAG, "Stack [%s]: peak %" PRIu32 " of %" PRIu32 " bytes", name, size - unused, size);
     }
-    buffer[2] = crc[0];
-    buffer[3] = crc[1];
-    // We ignore the response; just fire-and-forget.
-    return rc522_transceive(buffer, sizeof(buffer), NULL, NULL);
 }
 
-static bool rc522_get_tag(uint8_t *uid, size_t *uid_len) {
-    static uint32_t request_failures = 0;
-    static uint32_t anticoll_failures = 0;
+// Heap headroom and fragmentation (largest free block vs free), and the
+// stack high-water mark of each of our tasks.
+static void log_memory_stats(void) {
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "Heap: free=%u min_free=%u largest_block=%u (%u%% of free)",
+             (unsigned)free_bytes, (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned)largest, free_bytes ? (unsigned)(100 * largest / free_bytes) : 0);
+    log_task_stack("rfid_task", rfid_task_handle, RFID_TASK_STACK_SIZE);
+    log_task_stack("uplink_task", uplink_task_handle, UPLINK_TASK_STACK_SIZE);
+}
 
-    if (!rc522_initialized) {
-        return false;
+// Events waiting for the gateway, oldest first; only uplink_task uses them.
+// next_send_ms holds every send until the gateway's Retry-After (or our own
+// back-off) has passed, so a throttled device paces itself instead of
+// retrying into the limit.
+static scan_event_t event_backlog[EVENT_BACKLOG_LEN];
+static unsigned backlog_head = 0;
+static unsigned backlog_count = 0;
+static int64_t next_send_ms = 0;
+static uint32_t send_backoff_ms = 0;
+
+// At most this many sends per pass, so lookups for new scans are not held up
+// while a backlog drains.
+#define BACKLOG_SENDS_PER_PASS     4
+
+static void backlog_push(const scan_event_t *scan) {
+    if (backlog_count == EVENT_BACKLOG_LEN) {
+        ESP_LOGW(TAG, "Event backlog full, dropping oldest event %s", event_backlog[backlog_head].event_id);
+        backlog_head = (backlog_head + 1) % EVENT_BACKLOG_LEN;
+        backlog_count--;
     }
+    event_backlog[(backlog_head + backlog_count) % EVENT_BACKLOG_LEN] = *scan;
+    backlog_count++;
+}
 
-    esp_err_t req_err = rc522_request(PICC_REQIDL);
-    if (req_err != ESP_OK) {
-        request_failures++;
-        if (request_failures % 20 == 1) {
-            ESP_LOGW(TAG, "RFID request failed (%s). Check wiring/power. Failure count=%" PRIu32,
-                     esp_err_to_name(req_err), request_failures);
+// Hold the backlog for the gateway's Retry-After, or for a doubling back-off
+// when it gave none. Up to 20% jitter keeps readers throttled at the same
+// moment from coming back in lockstep.
+static void backlog_defer(int64_t now, uint32_t retry_after_ms) {
+    uint32_t delay = retry_after_ms;
+    if (delay == 0) {
+        send_backoff_ms = send_backoff_ms ? send_backoff_ms * 2 : EVENT_RETRY_MIN_MS;
+        if (send_backoff_ms > EVENT_RETRY_MAX_MS) {
+            send_backoff_ms = EVENT_RETRY_MAX_MS;
         }
-        return false;
+        delay = send_backoff_ms;
+    }
+    if (delay > EVENT_RETRY_MAX_MS) {
+        delay = EVENT_RETRY_MAX_MS;
     }
+    delay += esp_random() % (delay / 5 + 1);
+    next_send_ms = now + delay;
+    ESP_LOGW(TAG, "Holding %u event(s) for %" PRIu32 " ms", backlog_count, delay);
+}
 
-    size_t serial_length = 0;
-    esp_err_t anticoll_err = rc522_anticoll(uid, &serial_length);
-    if (anticoll_err != ESP_OK) {
-        anticoll_failures++;
-        if (anticoll_failures % 20 == 1) {
-            ESP_LOGW(TAG, "RFID anticollision failed (%s). Failure count=%" PRIu32,
-                     esp_err_to_name(anticoll_err), anticoll_failures);
+// Send held events in order until the gateway pushes back. Nothing goes out
+// before SNTP has set the clock, since each ts is derived from it.
+static void backlog_send(void) {
+    if (!clock_synced()) {
+        return;
+    }
+    for (int sent = 0; backlog_count > 0 && sent < BACKLOG_SENDS_PER_PASS; sent++) {
+        int64_t now = uptime_ms();
+        if (now < next_send_ms) {
+            return;
         }
-        return false;
+        uint32_t retry_after_ms;
+        if (send_event_to_gateway(&event_backlog[backlog_head], &retry_after_ms) == SEND_RETRY) {
+            backlog_defer(now, retry_after_ms);
+            return;
+        }
+        send_backoff_ms = 0;
+        backlog_head = (backlog_head + 1) % EVENT_BACKLOG_LEN;
+        backlog_count--;
     }
+}
 
-    rc522_halt();
-
-    if (uid_len) {
-        *uid_len = serial_length;
+// How long uplink_task may block on the scan queue. Offline it wakes every
+// 250 ms, so the connections are pre-warmed soon after an IP is assigned.
+static TickType_t uplink_wait_ticks(bool online) {
+    int64_t wait = online ? 1000 : 250;
+    if (backlog_count > 0 && online && clock_synced()) {
+        wait = next_send_ms - uptime_ms();
+        if (wait < 0) {
+            wait = 0;
+        } else if (wait > 1000) {
+            wait = 1000;
+        }
     }
-    return true;
+    return pdMS_TO_TICKS(wait);
 }
 
-static esp_err_t rc522_antenna_on(void) {
-    uint8_t value;
-    ESP_ERROR_CHECK(rc522_read_reg(RC522_REG_TX_CONTROL, &value));
-    if (!(value & 0x03)) {
-        ESP_ERROR_CHECK(rc522_set_bitmask(RC522_REG_TX_CONTROL, 0x03));
+// Uplink housekeeping deadlines, in uptime ms.
+static int64_t next_filter_ms = 0;
+static int64_t next_summary_ms = UNKNOWN_SUMMARY_FLUSH_MS;
+static int64_t next_memory_ms = 60 * 1000;
+
+// One scan from the queue: look the card up if the reader had no name for
+// it, then queue the event for the gateway unless it turned out to be
+// unregistered.
+static void uplink_handle_scan(const scan_event_t *scan) {
+    if (!scan->display_pending || resolve_and_show(scan)) {
+        backlog_push(scan);
     }
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_RFCFG, 0x60));
-    return ESP_OK;
 }
 
-static esp_err_t rc522_reset_sequence(void) {
-    gpio_config_t rst_conf = {
-        .pin_bit_mask = 1ULL << RC522_RST_PIN,
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_down_en = 0,
-        .pull_up_en = 0,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    ESP_ERROR_CHECK(gpio_config(&rst_conf));
+// Called when WiFi gets an IP: open the gateway connection with a cheap
+// GET /health, so the first tap after boot or a dropped link does not wait
+// for a full TLS handshake, and bring the filter refresh forward, which does
+// the same for the admin API. The sessions are then kept for resumption.
+static void http_prewarm(void) {
+    int64_t start = uptime_ms();
+    esp_http_client_set_method(gateway_http, HTTP_METHOD_GET);
+    esp_http_client_set_post_field(gateway_http, "", 0); // no body; keeps Content-Type
+    int status = http_request(gateway_http, GATEWAY_URL "/health", NULL);
+    esp_http_client_set_method(gateway_http, HTTP_METHOD_POST);
+    esp_http_client_set_url(gateway_http, GATEWAY_URL "/api/events");
+    ESP_LOGI(TAG, "Pre-warmed gateway connection in %lld ms (status: %d)", (long long)(uptime_ms() - start), status);
+    next_filter_ms = 0;
+}
+
+// Show what wifi_event_handler reported since the last pass and save a new AP.
+static void uplink_wifi_status(void) {
+    EventBits_t bits = xEventGroupClearBits(app_events, WIFI_STATUS_BITS);
+    if (bits & WIFI_SHOW_CONNECTING_BIT) {
+        oled_show_message("WiFi", "Connecting...");
+    }
+    if (bits & WIFI_SHOW_RECONNECTING_BIT) {
+        oled_show_message("WiFi", "Reconnecting...");
+    }
+    if (bits & WIFI_GOT_IP_BIT) {
+        wifi_save_ap_cache();
+        char ip_line[32];
+        snprintf(ip_line, sizeof(ip_line), "IP: " IPSTR, IP2STR(&wifi_ip));
+        oled_show_message("WiFi Connected", ip_line);
+    }
+}
 
-    gpio_set_level(RC522_RST_PIN, 0);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    gpio_set_level(RC522_RST_PIN, 1);
-    vTaskDelay(pdMS_TO_TICKS(10));
+// Tracks WiFi for uplink_task and pre-warms on the way up.
+static bool uplink_online = false;
 
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_COMMAND, RC522_CMD_SOFT_RESET));
-    vTaskDelay(pdMS_TO_TICKS(50));
-    return ESP_OK;
+static bool uplink_check_online(void) {
+    bool online = wifi_connected();
+    if (online && !uplink_online) {
+        http_prewarm();
+    }
+    uplink_online = online;
+    return online;
 }
 
-static esp_err_t rc522_configure(void) {
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_T_MODE, 0x8D));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_T_PRESCALER, 0x3E));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_T_RELOAD_L, 30));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_T_RELOAD_H, 0));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_TX_ASK, 0x40));
-    ESP_ERROR_CHECK(rc522_write_reg(RC522_REG_MODE, 0x3D));
-    return rc522_antenna_on();
+// Memory and TLS report, unknown-card summary and UID filter refresh, when
+// due.
+static void uplink_housekeeping(int64_t now, bool online) {
+    if (now >= next_memory_ms) {
+        log_memory_stats();
+        log_tls_stats(&gateway_tls);
+        log_tls_stats(&admin_tls);
+        log_tls_stats(&lookup_tls);
+        next_memory_ms = now + MEMORY_STATS_INTERVAL_MS;
+    }
+    if (!online) {
+        return;
+    }
+    if (now >= next_summary_ms && clock_synced()) {
+        if (unknown_summary_flush()) {
+            next_filter_ms = 0;
+        }
+        next_summary_ms = now + UNKNOWN_SUMMARY_FLUSH_MS;
+    }
+    if (now >= next_filter_ms) {
+        uid_filter_refresh();
+        next_filter_ms = now + UID_FILTER_REFRESH_MS;
+    }
 }
 
-static esp_err_t rc522_init(void) {
-    if (rc522_initialized) {
-        return ESP_OK;
+// Drains the scan queue into the backlog above, which holds events while
+// offline and sends them once WiFi is up. The loop never blocks on WiFi, so
+// the status display and housekeeping keep running between scans.
+static void uplink_task(void *pvParameters) {
+    http_clients_init();
+    scan_event_t scan;
+    while (1) {
+        if (xQueueReceive(scan_queue, &scan, uplink_wait_ticks(uplink_online)) == pdTRUE) {
+            if (!uplink_check_online()) {
+                // No lookup offline; by the time one could run the student
+                // has left the reader.
+                scan.display_pending = false;
+            }
+            uplink_handle_scan(&scan);
+        }
+        uplink_wifi_status();
+        bool online = uplink_check_online();
+        if (online) {
+            backlog_send();
+        }
+        uplink_housekeeping(uptime_ms(), online);
     }
+}
 
-    spi_bus_config_t buscfg = {
-        .mosi_io_num = RC522_MOSI_PIN,
-        .miso_io_num = RC522_MISO_PIN,
-        .sclk_io_num = RC522_SCK_PIN,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = 0,
-        .flags = 0,
-    };
+// A recovery leaves the antenna on; keep the scheduler's radio accounting in step.
+static void reader_supervise(reader_t *reader, esp_err_t err) {
+    if (rc522_supervise(&reader->dev, err)) {
+        rfid_sched_antenna_changed(&reader->sched, true, uptime_ms());
+    }
+}
 
-    esp_err_t ret = spi_bus_initialize(RC522_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
-    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-        return ret;
+// One step for one reader; sets reader->next_ms instead of sleeping, so a
+// reader waiting for a card to leave or backing off never holds up the others.
+static void reader_service(reader_t *reader, int64_t now) {
+    rc522_t *dev = &reader->dev;
+    rfid_sched_t *sched = &reader->sched;
+
+    if (!dev->initialized) {
+        esp_err_t err = rc522_init(dev);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "UHOH, Failed to init MFRC522 (gate %s): %s", dev->cfg.gate_id, esp_err_to_name(err));
+            reader->next_ms = now + 1000;
+            return;
+        }
+        reader->last_health_ms = uptime_ms();
+        if (boot_metrics.reader_ms == 0) {
+            boot_metrics.reader_ms = uptime_ms();
+            xEventGroupSetBits(app_events, READER_READY_BIT);
+            ESP_LOGI(TAG, "Boot: reader ready at %lld ms", (long long)boot_metrics.reader_ms);
+        }
+        reader->next_ms = uptime_ms();
+        return;
     }
 
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = 5 * 1000 * 1000,
-        .mode = 0,
-        .spics_io_num = RC522_SDA_PIN,
-        .queue_size = 1,
-        .flags = 0, // full-duplex transactions (required for register reads)
-    };
+    if (!sched->antenna_on) {
+        reader_supervise(reader, rc522_antenna_on(dev));
+        rfid_sched_antenna_changed(sched, true, uptime_ms());
+        reader->next_ms = uptime_ms() + RC522_ANTENNA_SETTLE_MS;
+        return;
+    }
 
-    ret = spi_bus_add_device(RC522_SPI_HOST, &devcfg, &rc522_spi);
-    if (ret != ESP_OK) {
-        return ret;
+    // After a read, wait for the card to leave instead of pausing blindly.
+    if (sched->awaiting_removal) {
+        esp_err_t err = rc522_card_present(dev);
+        reader_supervise(reader, err);
+        bool removed = rfid_sched_on_removal_check(sched, err == ESP_OK, uptime_ms());
+        reader->next_ms = uptime_ms() + (removed ? 0 : RFID_REMOVAL_CHECK_MS);
+        return;
     }
 
-    ESP_ERROR_CHECK(rc522_reset_sequence());
-    ESP_ERROR_CHECK(rc522_configure());
+    if (now - reader->last_health_ms >= RC522_HEALTH_CHECK_MS) {
+        reader->last_health_ms = now;
+        if (rc522_health_check(dev)) {
+            rfid_sched_antenna_changed(sched, true, uptime_ms());
+        }
+    }
 
-    uint8_t version = 0;
-    esp_err_t version_err = rc522_read_reg(RC522_REG_VERSION, &version);
-    if (version_err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read MFRC522 version register: %s", esp_err_to_name(version_err));
-        return version_err;
+    uint8_t uid[MFRC522_MAX_LEN] = {0};
+    size_t uid_len = 0;
+    esp_err_t err = rc522_get_tag(dev, uid, &uid_len);
+    reader_supervise(reader, err);
+    if (err == ESP_OK) {
+        rfid_sched_on_card(sched, uptime_ms());
+        handle_card(reader, uid, uid_len);
+        reader->next_ms = uptime_ms() + RFID_REMOVAL_CHECK_MS;
+        return;
     }
 
-    ESP_LOGI(TAG, "MFRC522 version register: 0x%02X", version);
-    if (version == 0x00 || version == 0xFF) {
-        ESP_LOGE(TAG, "Invalid MFRC522 version response. Expected 0x90/0x91/0x92. Check SPI wiring (SCK/MOSI/MISO/SDA) and power.");
-        return ESP_FAIL;
+    uint32_t wait_ms = rfid_sched_on_idle_poll(sched, uptime_ms(), local_hour());
+    if (rfid_sched_antenna_may_idle(sched) && rc522_antenna_off(dev) == ESP_OK) {
+        rfid_sched_antenna_changed(sched, false, uptime_ms());
     }
+    reader->next_ms = uptime_ms() + wait_ms;
+}
 
-    rc522_initialized = true;
-    ESP_LOGI(TAG, "MFRC522 ready (direct SPI mode)");
-    return ESP_OK;
+static void log_reader_stats(int64_t now) {
+    for (size_t i = 0; i < READER_COUNT; i++) {
+        const reader_t *reader = &readers[i];
+        rfid_sched_stats_t st = rfid_sched_stats(&reader->sched, now);
+        ESP_LOGI(TAG, "RFID polling [%s]: polls=%" PRIu64 " cards=%" PRIu64 " radio_on=%.1f%% interval=%" PRIu32 "ms",
+                 reader->dev.cfg.gate_id, st.polls, st.cards,
+                 100.0 * (double)st.radio_on_ms / (double)now, reader->sched.interval_ms);
+        ESP_LOGI(TAG, "RFID health [%s]: transport_errors=%" PRIu32 " protocol_errors=%" PRIu32
+                 " recoveries=%" PRIu32 " recovery_failures=%" PRIu32,
+                 reader->dev.cfg.gate_id, reader->dev.health.transport_errors,
+                 reader->dev.health.protocol_errors, reader->dev.health.recoveries,
+                 reader->dev.health.recovery_failures);
+    }
 }
 
 static void rfid_reader_task(void *pvParameters) {
-    ESP_LOGI(TAG, "RFID reader task started");
+    ESP_LOGI(TAG, "RFID reader task started (%u reader(s))", (unsigned)READER_COUNT);
+
+    static const rfid_sched_profile_t profiles[] = {
+        {
+            .start_hour = RFID_POLL_OPEN_START_HOUR,
+            .end_hour = RFID_POLL_OPEN_END_HOUR,
+            .fast_ms = RFID_POLL_FAST_MS,
+            .idle_max_ms = RFID_POLL_OPEN_IDLE_MAX_MS,
+        },
+        {
+            .start_hour = RFID_POLL_OPEN_END_HOUR,
+            .end_hour = RFID_POLL_OPEN_START_HOUR,
+            .fast_ms = RFID_POLL_FAST_MS,
+            .idle_max_ms = RFID_POLL_CLOSED_IDLE_MAX_MS,
+        },
+    };
+    const rfid_sched_config_t sched_cfg = {
+        .profiles = profiles,
+        .profile_count = sizeof(profiles) / sizeof(profiles[0]),
+        // Until SNTP sets the clock, poll as if the library is open.
+        .fallback = {
+            .fast_ms = RFID_POLL_FAST_MS,
+            .idle_max_ms = RFID_POLL_OPEN_IDLE_MAX_MS,
+        },
+        .hot_window_ms = RFID_POLL_HOT_WINDOW_MS,
+        .antenna_off_threshold_ms = RFID_ANTENNA_OFF_THRESHOLD_MS,
+        .removal_check_ms = RFID_REMOVAL_CHECK_MS,
+        .removal_misses = 2,
+    };
 
-    while (1) {
-        uint8_t uid[MFRC522_MAX_LEN] = {0};
-        size_t uid_len = 0;
+    // Bring the readers up here so app_main can initialise the display meanwhile.
+    esp_err_t err = rc522_bus_init(RC522_SPI_HOST, RC522_MOSI_PIN, RC522_MISO_PIN, RC522_SCK_PIN);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UHOH, Failed to init RC522 SPI bus: %s", esp_err_to_name(err));
+        vTaskDelete(NULL);
+        return;
+    }
+    // Attach every reader before talking to any, so all chip selects idle high.
+    for (size_t i = 0; i < READER_COUNT; i++) {
+        err = rc522_attach(&readers[i].dev, RC522_SPI_HOST, &reader_configs[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "UHOH, Failed to attach MFRC522 (gate %s): %s",
+                     reader_configs[i].gate_id, esp_err_to_name(err));
+        }
+        rfid_sched_init(&readers[i].sched, &sched_cfg, uptime_ms());
+    }
 
-        if (rc522_get_tag(uid, &uid_len)) {
-            char uid_hex[32] = {0};
-            for (size_t i = 0; i < uid_len && (i * 2 + 1) < sizeof(uid_hex); i++) {
-                snprintf(&uid_hex[i * 2], sizeof(uid_hex) - (i * 2), "%02X", uid[i]);
-            }
+    size_t next = 0;
+    int64_t last_stats_ms = uptime_ms();
 
-            ESP_LOGI(TAG, "@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#");
-            ESP_LOGI(TAG, "RFID CARD DETECTED!");
-            ESP_LOGI(TAG, "UID: %s", uid_hex);
-            ESP_LOGI(TAG, "Passing to gateway"...");
-            ESP_LOGI(TAG, "@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#@#");
-            rfid_cache_entry_t *cache_entry = rfid_cache_get(uid_hex);
-            if (cache_entry->name[0] == '\0') {
-                if (fetch_student_info(uid_hex, cache_entry) != ESP_OK) {
-                    strncpy(cache_entry->name, uid_hex, sizeof(cache_entry->name) - 1);
-                    cache_entry->name[sizeof(cache_entry->name) - 1] = '\0';
-                    strcpy(cache_entry->next_event, "entry");
-                }
+    while (1) {
+        int64_t now = uptime_ms();
+
+        // Serve the first due reader after the last one served, so a busy gate
+        // cannot starve the others of bus time.
+        reader_t *due = NULL;
+        int64_t earliest = INT64_MAX;
+        for (size_t k = 0; k < READER_COUNT; k++) {
+            size_t idx = (next + k) % READER_COUNT;
+            if (readers[idx].dev.spi == NULL) {
+                continue; // failed to attach
+            }
+            if (readers[idx].next_ms <= now) {
+                due = &readers[idx];
+                next = (idx + 1) % READER_COUNT;
+                break;
+            }
+            if (readers[idx].next_ms < earliest) {
+                earliest = readers[idx].next_ms;
             }
+        }
+        if (due) {
+            reader_service(due, now);
+            continue;
+        }
 
-            bool is_entry = strcasecmp(cache_entry->next_event, "exit") != 0;
-            send_event_to_gateway(uid_hex);
-            oled_show_event(cache_entry->name[0] ? cache_entry->name : uid_hex, is_entry);
-            strcpy(cache_entry->next_event, is_entry ? "exit" : "entry");
-            vTaskDelay(pdMS_TO_TICKS(1000));
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(125));
+        if (now - last_stats_ms >= 10 * 60 * 1000) {
+            log_reader_stats(now);
+            last_stats_ms = now;
         }
+
+        if (earliest == INT64_MAX) {
+            ESP_LOGE(TAG, "No RC522 readers attached");
+            vTaskDelete(NULL);
+            return;
+        }
+        delay_ms((uint32_t)(earliest - now));
     }
 }
 
@@ -734,18 +1514,30 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(ret);
 
-    init_oled_display();
+    app_events = xEventGroupCreateStatic(&app_events_buf);
+    scan_queue = xQueueCreateStatic(SCAN_QUEUE_LEN, sizeof(scan_event_t), scan_queue_storage, &scan_queue_buf);
+    cache_lock = xSemaphoreCreateMutexStatic(&cache_lock_buf);
+    oled_lock = xSemaphoreCreateMutexStatic(&oled_lock_buf);
+    unknown_lock = xSemaphoreCreateMutexStatic(&unknown_lock_buf);
+    uid_filter_load();
+    event_seq_init();
 
+    // Association runs in the background; nothing below waits for it.
     wifi_init();
 
-    vTaskDelay(pdMS_TO_TICKS(2000));
+    // Local time drives the per-hour polling profiles.
+    setenv("TZ", DEVICE_TZ, 1);
+    tzset();
+    esp_sntp_config_t sntp_cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
+    esp_netif_sntp_init(&sntp_cfg);
 
-    esp_err_t rfid_err = rc522_init();
-    if (rfid_err != ESP_OK) {
-        ESP_LOGE(TAG, "UHOH, Failed to init MFRC522: %s", esp_err_to_name(rfid_err));
-    }
+    rfid_task_handle = xTaskCreateStatic(rfid_reader_task, "rfid_task", RFID_TASK_STACK_SIZE, NULL, 5,
+                                         rfid_task_stack, &rfid_task_tcb);
+    uplink_task_handle = xTaskCreateStatic(uplink_task, "uplink_task", UPLINK_TASK_STACK_SIZE, NULL, 4,
+                                           uplink_task_stack, &uplink_task_tcb);
 
-    xTaskCreate(rfid_reader_task, "rfid_task", 4096, NULL, 5, NULL);
+    // The reader initialises on its own task while the display comes up here.
+    init_oled_display();
 
     ESP_LOGI(TAG, "System UP");
 }
@@ -0,0 +1,199 @@
+package main
+
+import (
+	"context"
+	"math"
+	"net/http"
+	"strconv"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// tokenBucket refills at rate tokens per second up to burst. Callers hold
+// the owning Admission's lock.
+type tokenBucket struct {
+	rate   float64
+	burst  float64
+	tokens float64
+	last   time.Time
+}
+
+func newTokenBucket(rate float64, burst int, now time.Time) *tokenBucket {
+	return &tokenBucket{rate: rate, burst: float64(burst), tokens: float64(burst), last: now}
+}
+
+// take removes one token, or reports how long until one is available.
+func (b *tokenBucket) take(now time.Time) (bool, time.Duration) {
+	b.tokens = math.Min(b.burst, b.tokens+now.Sub(b.last).Seconds()*b.rate)
+	b.last = now
+	if b.tokens >= 1 {
+		b.tokens--
+		return true, 0
+	}
+	return false, time.Duration((1 - b.tokens) / b.rate * float64(time.Second))
+}
+
+// Admission decides whether an authenticated request may reach the
+// database. Each device gets its own token bucket so one replaying reader
+// cannot use up the shared budget; the global bucket caps the fleet as a
+// whole. DB writers are bounded by a semaphore: a request that cannot get a
+// slot within DBQueueTimeout is turned away with 429 rather than buffered,
+// so the device holds the event and the pool is not queued up further.
+type Admission struct {
+	mu          sync.Mutex
+	deviceRate  float64
+	deviceBurst int
+	global      *tokenBucket
+	devices     map[string]*tokenBucket
+
+	dbSlots        chan struct{}
+	dbQueueTimeout time.Duration
+
+	ThrottledDevice int64
+	ThrottledGlobal int64
+	DBBusy          int64
+}
+
+func NewAdmission(c Config) *Admission {
+	now := time.Now()
+	return &Admission{
+		deviceRate:     c.DeviceRate,
+		deviceBurst:    c.DeviceBurst,
+		global:         newTokenBucket(c.GlobalRate, c.GlobalBurst, now),
+		devices:        make(map[string]*tokenBucket),
+		dbSlots:        make(chan struct{}, c.DBMaxInflight),
+		dbQueueTimeout: c.DBQueueTimeout,
+	}
+}
+
+// Allow charges one request to deviceID and to the global bucket. When
+// either is empty it returns false and the time until a retry can succeed.
+func (a *Admission) Allow(deviceID string) (bool, time.Duration) {
+	now := time.Now()
+	a.mu.Lock()
+	defer a.mu.Unlock()
+
+	dev, ok := a.devices[deviceID]
+	if !ok {
+		// Keyed by authenticated device_id, so the map is bounded by
+		// device_registry.
+		dev = newTokenBucket(a.deviceRate, a.deviceBurst, now)
+		a.devices[deviceID] = dev
+	}
+	if ok, wait := dev.take(now); !ok {
+		atomic.AddInt64(&a.ThrottledDevice, 1)
+		return false, wait
+	}
+	if ok, wait := a.global.take(now); !ok {
+		// Give the device its token back; it was not the one overloading us.
+		dev.tokens++
+		atomic.AddInt64(&a.ThrottledGlobal, 1)
+		return false, wait
+	}
+	return true, 0
+}
+
+// AcquireDB waits up to DBQueueTimeout for a writer slot. The caller must
+// ReleaseDB when it returns true.
+func (a *Admission) AcquireDB(ctx context.Context) bool {
+	select {
+	case a.dbSlots <- struct{}{}:
+		return true
+	default:
+	}
+	timer := time.NewTimer(a.dbQueueTimeout)
+	defer timer.Stop()
+	select {
+	case a.dbSlots <- struct{}{}:
+		return true
+	case <-timer.C:
+	case <-ctx.Done():
+	}
+	atomic.AddInt64(&a.DBBusy, 1)
+	return false
+}
+
+// WaitDB blocks for a writer slot; used by the retry worker, which has no
+// client to push back on.
+func (a *Admission) WaitDB() {
+	a.dbSlots <- struct{}{}
+}
+
+func (a *Admission) ReleaseDB() {
+	<-a.dbSlots
+}
+
+// InflightDB is the number of writer slots in use.
+func (a *Admission) InflightDB() int {
+	return len(a.dbSlots)
+}
+
+// writeTooManyRequests answers 429 with a whole-second Retry-After, which
+// is the form the firmware parses.
+func writeTooManyRequests(w http.ResponseWriter, wait time.Duration) {
+	secs := int(math.Ceil(wait.Seconds()))
+	if secs < 1 {
+		secs = 1
+	}
+	w.Header().Set("Retry-After", strconv.Itoa(secs))
+	w.WriteHeader(http.StatusTooManyRequests)
+}
+
+// authCache keeps token hash -> device_id lookups for ttl so authentication
+// does not cost a query per request; a flooding device is then throttled
+// without touching the database. Unknown tokens are remembered for a
+// shorter time. Revoking a device takes effect within ttl.
+type authCache struct {
+	mu      sync.Mutex
+	ttl     time.Duration
+	entries map[string]authEntry
+}
+
+type authEntry struct {
+	deviceID string
+	expires  time.Time
+}
+
+const (
+	authNegativeTTL     = 10 * time.Second
+	authCacheMaxEntries = 10000
+)
+
+func newAuthCache(ttl time.Duration) *authCache {
+	return &authCache{ttl: ttl, entries: make(map[string]authEntry)}
+}
+
+// get returns the cached device_id ("" for a known-bad token) and whether
+// the entry was present.
+func (c *authCache) get(hash string) (string, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	e, ok := c.entries[hash]
+	if !ok || time.Now().After(e.expires) {
+		return "", false
+	}
+	return e.deviceID, true
+}
+
+func (c *authCache) put(hash, deviceID string) {
+	ttl := c.ttl
+	if deviceID == "" {
+		ttl = min(ttl, authNegativeTTL)
+	}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if len(c.entries) >= authCacheMaxEntries {
+		// Random garbage tokens should not grow the map without bound.
+		now := time.Now()
+		for k, e := range c.entries {
+			if now.After(e.expires) {
+				delete(c.entries, k)
+			}
+		}
+		if len(c.entries) >= authCacheMaxEntries {
+			return
+		}
+	}
+	c.entries[hash] = authEntry{deviceID: deviceID, expires: time.Now().Add(ttl)}
+}
@@ -0,0 +1,50 @@
+package main
+
+import (
+	"log"
+	"time"
+)
+
+const (
+	partitionMaintenanceInterval = 6 * time.Hour
+	partitionMonthsAhead         = 3
+)
+
+// partitionMaintenance creates the monthly attendance/events_raw partitions
+// ahead of time (see migrations/06-partition-attendance.sql) so inserts never
+// fall into the default partition, and drops events_raw partitions past the
+// retention period.
+func (g *Gateway) partitionMaintenance() {
+	for {
+		var created int
+		if err := g.db.QueryRow("SELECT ensure_attendance_partitions($1)", partitionMonthsAhead).Scan(&created); err != nil {
+			log.Printf("Partition maintenance failed: %v", err)
+		} else if created > 0 {
+			log.Printf("Created %d monthly partition(s)", created)
+		}
+
+		if months := g.config.EventsRawRetentionMonths; months > 0 {
+			g.pruneEventsRaw(months)
+		}
+
+		time.Sleep(partitionMaintenanceInterval)
+	}
+}
+
+func (g *Gateway) pruneEventsRaw(keepMonths int) {
+	rows, err := g.db.Query("SELECT prune_events_raw_partitions($1)", keepMonths)
+	if err != nil {
+		log.Printf("events_raw retention failed: %v", err)
+		return
+	}
+	defer rows.Close()
+	for rows.Next() {
+		var name string
+		if err := rows.Scan(&name); err == nil {
+			log.Printf("Dropped events_raw partition %s (retention %d months)", name, keepMonths)
+		}
+	}
+	if err := rows.Err(); err != nil {
+		log.Printf("events_raw retention failed: %v", err)
+	}
+}
@@ -0,0 +1,126 @@
+package main
+
+import (
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"io"
+	"log"
+	"net/http"
+	"sync/atomic"
+	"time"
+)
+
+// PublishedEvent is a committed attendance event as pushed to the admin API.
+type PublishedEvent struct {
+	EventID     string `json:"event_id"`
+	DeviceID    string `json:"device_id"`
+	AdmissionNo string `json:"admission_no"`
+	EventType   string `json:"event_type"`
+	TS          string `json:"ts"`
+	GateID      string `json:"gate_id,omitempty"`
+}
+
+// EventPublisher pushes committed events to the admin API's
+// /internal/events/batch, which fans them out over /ws/events. Events
+// arriving within FlushInterval of each other go out in one request over a
+// single keep-alive connection. Delivery is best effort: when the admin API
+// is down or the queue is full, events are dropped, and dashboards catch up
+// on their next fetch.
+type EventPublisher struct {
+	url           string
+	client        *http.Client
+	events        chan PublishedEvent
+	flushInterval time.Duration
+	maxBatch      int
+
+	Published int64
+	Dropped   int64
+	Batches   int64
+	Failures  int64
+}
+
+func NewEventPublisher(adminURL string, flushInterval time.Duration) *EventPublisher {
+	transport := &http.Transport{
+		MaxIdleConns:        1,
+		MaxIdleConnsPerHost: 1,
+		MaxConnsPerHost:     1,
+		IdleConnTimeout:     90 * time.Second,
+	}
+	return &EventPublisher{
+		url:           adminURL + "/internal/events/batch",
+		client:        &http.Client{Transport: transport, Timeout: 5 * time.Second},
+		events:        make(chan PublishedEvent, 4096),
+		flushInterval: flushInterval,
+		maxBatch:      500,
+	}
+}
+
+// Publish queues an event without blocking the write path.
+func (p *EventPublisher) Publish(ev PublishedEvent) {
+	if p == nil {
+		return
+	}
+	select {
+	case p.events <- ev:
+	default:
+		atomic.AddInt64(&p.Dropped, 1)
+	}
+}
+
+func (p *EventPublisher) Run() {
+	batch := make([]PublishedEvent, 0, p.maxBatch)
+	timer := time.NewTimer(p.flushInterval)
+	timer.Stop()
+
+	for {
+		// Block for the first event, then collect whatever else arrives
+		// before the flush interval ends.
+		batch = append(batch[:0], <-p.events)
+		timer.Reset(p.flushInterval)
+	collect:
+		for len(batch) < p.maxBatch {
+			select {
+			case ev := <-p.events:
+				batch = append(batch, ev)
+			case <-timer.C:
+				break collect
+			}
+		}
+		if !timer.Stop() {
+			select {
+			case <-timer.C:
+			default:
+			}
+		}
+
+		if err := p.send(batch); err != nil {
+			failures := atomic.AddInt64(&p.Failures, 1)
+			atomic.AddInt64(&p.Dropped, int64(len(batch)))
+			if failures%20 == 1 {
+				log.Printf("Failed to publish %d event(s) to admin API: %v (failures=%d)", len(batch), err, failures)
+			}
+			continue
+		}
+		atomic.AddInt64(&p.Published, int64(len(batch)))
+		atomic.AddInt64(&p.Batches, 1)
+	}
+}
+
+func (p *EventPublisher) send(batch []PublishedEvent) error {
+	body, err := json.Marshal(map[string]any{"events": batch})
+	if err != nil {
+		return err
+	}
+	resp, err := p.client.Post(p.url, "application/json", bytes.NewReader(body))
+	if err != nil {
+		return err
+	}
+	// Drain the body so the connection goes back to the pool.
+	io.Copy(io.Discard, resp.Body)
+	resp.Body.Close()
+	if resp.StatusCode != http.StatusOK {
+		return fmt.Errorf("unexpected status %d", resp.StatusCode)
+	}
+	return nil
+}
@@ -0,0 +1,131 @@
+package main
+
+import (
+	"database/sql"
+	"errors"
+	"log"
+	"time"
+)
+
+// reorderWindow bounds how far behind the student's latest event a late
+// event may be and still re-toggle the events after it. An older one is
+// stored with the toggle of the event before it and the rest is left alone.
+const reorderWindow = 24 * time.Hour
+
+// precedingEventType is the type of the student's latest event at or before
+// ts, or "" when there is none.
+func precedingEventType(tx *sql.Tx, admissionNo string, ts time.Time) (string, error) {
+	var eventType string
+	err := tx.QueryRow(
+		`SELECT event_type FROM attendance
+		 WHERE admission_no = $1 AND ts <= $2
+		 ORDER BY ts DESC, id DESC LIMIT 1`,
+		admissionNo, ts,
+	).Scan(&eventType)
+	if errors.Is(err, sql.ErrNoRows) {
+		return "", nil
+	}
+	return eventType, err
+}
+
+type laterEvent struct {
+	id        int64
+	eventID   string
+	deviceID  string
+	ts        time.Time
+	eventType string
+	gateID    string
+}
+
+// retoggleAfter is writeEvent's path for a late event that was just
+// inserted as eventType. Events after it that took their type from the
+// toggle are flipped where the late event changes the chain (gate-fixed
+// events keep theirs and restart it), their hourly/daily counts move with
+// them, and attendance_state and occupancy take the type the chain now ends
+// on. The caller holds the attendance_state row lock.
+//
+// Flipped rows get a new processed_at, so updated_since readers and the
+// Parquet export pick them up, and are returned for the caller to publish
+// once the transaction commits.
+func retoggleAfter(tx *sql.Tx, admissionNo, eventID string, ts time.Time, eventType, stateType string, stateTS time.Time) ([]PublishedEvent, error) {
+	entries, exits := 0, 1
+	if eventType == "entry" {
+		entries, exits = 1, 0
+	}
+	if err := applyRollups(tx, admissionNo, ts, entries, exits, 0); err != nil {
+		return nil, err
+	}
+	if stateTS.Sub(ts) > reorderWindow {
+		log.Printf("Event %s for %s is %s behind the latest; stored without re-toggling later events",
+			eventID, admissionNo, stateTS.Sub(ts).Round(time.Second))
+		return nil, nil
+	}
+
+	rows, err := tx.Query(
+		`SELECT a.id, a.event_id, COALESCE(a.device_id, ''), a.ts, a.event_type, COALESCE(r.raw_json->>'gate_id', '')
+		 FROM attendance a
+		 LEFT JOIN events_raw r ON r.event_id = a.event_id AND r.ts = a.ts
+		 WHERE a.admission_no = $1 AND a.ts > $2 AND a.ts <= $3
+		 ORDER BY a.ts, a.id`,
+		admissionNo, ts, stateTS,
+	)
+	if err != nil {
+		return nil, err
+	}
+	var later []laterEvent
+	for rows.Next() {
+		var e laterEvent
+		if err := rows.Scan(&e.id, &e.eventID, &e.deviceID, &e.ts, &e.eventType, &e.gateID); err != nil {
+			rows.Close()
+			return nil, err
+		}
+		later = append(later, e)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return nil, err
+	}
+
+	var flipped []PublishedEvent
+	prev := eventType
+	for _, e := range later {
+		want := "entry"
+		if gateType, ok := gateEventType(e.gateID); ok {
+			want = gateType
+		} else if prev == "entry" {
+			want = "exit"
+		}
+		if want != e.eventType {
+			if _, err := tx.Exec(
+				`UPDATE attendance SET event_type = $1, processed_at = now() WHERE id = $2 AND ts = $3`,
+				want, e.id, e.ts,
+			); err != nil {
+				return nil, err
+			}
+			moved := 1
+			if want != "entry" {
+				moved = -1
+			}
+			if err := applyRollups(tx, admissionNo, e.ts, moved, -moved, 0); err != nil {
+				return nil, err
+			}
+			flipped = append(flipped, PublishedEvent{
+				EventID:     e.eventID,
+				DeviceID:    e.deviceID,
+				AdmissionNo: admissionNo,
+				EventType:   want,
+				TS:          e.ts.UTC().Format(time.RFC3339Nano),
+				GateID:      e.gateID,
+			})
+		}
+		prev = want
+	}
+
+	if prev == stateType {
+		return flipped, nil
+	}
+	if _, err := tx.Exec(`UPDATE attendance_state SET last_event_type = $2 WHERE admission_no = $1`, admissionNo, prev); err != nil {
+		return nil, err
+	}
+	return flipped, applyRollups(tx, admissionNo, stateTS, 0, 0, occupancyDelta(stateType, prev))
+}
@@ -0,0 +1,95 @@
+package main
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+// seqWindow is how far below a device's highest sequence number individual
+// numbers are remembered.
+const seqWindow = 64
+
+type seqVerdict int
+
+const (
+	seqUnknown   seqVerdict = iota // no sequence, or too old to tell: left to the database
+	seqNew                         // above the high-water mark
+	seqLate                        // inside the window and not seen: arrived out of order
+	seqDuplicate                   // inside the window and already accepted
+)
+
+type deviceSeq struct {
+	epoch uint32
+	high  uint64
+	seen  uint64 // bit i set: high-i was accepted
+}
+
+// SeqTracker keeps, per device, the highest event sequence number accepted
+// and which of the seqWindow numbers below it were, so a retransmit or a
+// replay is answered without touching the database. Devices number events
+// from NVS; the epoch changes when a device's NVS is erased, which starts
+// its window again. State is in memory only: after a restart the first
+// retransmits fall through to ON CONFLICT (event_id, ts) as before.
+type SeqTracker struct {
+	mu      sync.Mutex
+	devices map[string]*deviceSeq
+
+	Duplicates int64
+	Late       int64
+	Resets     int64
+}
+
+func NewSeqTracker() *SeqTracker {
+	return &SeqTracker{devices: make(map[string]*deviceSeq)}
+}
+
+// Check classifies seq without recording it.
+func (t *SeqTracker) Check(deviceID string, epoch uint32, seq uint64) seqVerdict {
+	if seq == 0 {
+		return seqUnknown
+	}
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	d, ok := t.devices[deviceID]
+	switch {
+	case !ok || d.epoch != epoch || seq > d.high:
+		return seqNew
+	case d.high-seq >= seqWindow:
+		return seqUnknown
+	case d.seen&(1<<(d.high-seq)) != 0:
+		atomic.AddInt64(&t.Duplicates, 1)
+		return seqDuplicate
+	default:
+		atomic.AddInt64(&t.Late, 1)
+		return seqLate
+	}
+}
+
+// Accept records seq once the event has been stored or buffered.
+func (t *SeqTracker) Accept(deviceID string, epoch uint32, seq uint64) {
+	if seq == 0 {
+		return
+	}
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	// Keyed by authenticated device_id, so bounded by device_registry.
+	d, ok := t.devices[deviceID]
+	if !ok || d.epoch != epoch {
+		if ok {
+			atomic.AddInt64(&t.Resets, 1)
+		}
+		t.devices[deviceID] = &deviceSeq{epoch: epoch, high: seq, seen: 1}
+		return
+	}
+	switch {
+	case seq > d.high:
+		if shift := seq - d.high; shift < seqWindow {
+			d.seen = d.seen<<shift | 1
+		} else {
+			d.seen = 1
+		}
+		d.high = seq
+	case d.high-seq < seqWindow:
+		d.seen |= 1 << (d.high - seq)
+	}
+}
@@ -0,0 +1,224 @@
+package main
+
+import (
+	"database/sql"
+	"encoding/json"
+	"log"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// sighting is what is known about one unregistered UID since the last
+// flush. The last_* fields come from the most recent tap by ts.
+type sighting struct {
+	RFIDUID     string    `json:"rfid_uid"`
+	Count       int       `json:"count"`
+	FirstSeen   time.Time `json:"first_seen"`
+	LastSeen    time.Time `json:"last_seen"`
+	DeviceID    string    `json:"device_id"`
+	EventID     string    `json:"event_id"`
+	TS          string    `json:"ts"`
+	AdmissionNo string    `json:"admission_no,omitempty"`
+	GateID      string    `json:"gate_id,omitempty"`
+}
+
+// merge folds o into s: counts add, the seen range widens and the last
+// event is whichever is newer.
+func (s *sighting) merge(o *sighting) {
+	s.Count += o.Count
+	if o.FirstSeen.Before(s.FirstSeen) {
+		s.FirstSeen = o.FirstSeen
+	}
+	if !o.LastSeen.Before(s.LastSeen) {
+		s.LastSeen = o.LastSeen
+		s.DeviceID, s.EventID, s.TS = o.DeviceID, o.EventID, o.TS
+		s.AdmissionNo, s.GateID = o.AdmissionNo, o.GateID
+	}
+}
+
+// SightingAggregator collects taps by unregistered cards that reach
+// /api/events and writes them to rfid_unassigned as one multi-row upsert
+// per interval, so a card read over and over is one row update per flush
+// rather than one per tap. A failed flush merges its rows back into the
+// pending set, so counts stay exact across flushes; only taps that arrive
+// while maxSightingUIDs distinct UIDs are already pending are dropped.
+type SightingAggregator struct {
+	db        *sql.DB
+	admission *Admission
+	interval  time.Duration
+
+	mu      sync.Mutex
+	pending map[string]*sighting
+	stop    chan struct{}
+	done    chan struct{}
+
+	Recorded    int64
+	Dropped     int64
+	Flushes     int64
+	FlushErrors int64
+}
+
+const maxSightingUIDs = 10000
+
+func NewSightingAggregator(db *sql.DB, admission *Admission, interval time.Duration) *SightingAggregator {
+	return &SightingAggregator{
+		db:        db,
+		admission: admission,
+		interval:  interval,
+		pending:   make(map[string]*sighting),
+		stop:      make(chan struct{}),
+		done:      make(chan struct{}),
+	}
+}
+
+// Record notes one tap; it does not touch the database.
+func (a *SightingAggregator) Record(req EventRequest) {
+	if req.RFIDUID == "" {
+		return
+	}
+	seen := time.Now()
+	if parsed, err := time.Parse(time.RFC3339, req.TS); err == nil {
+		seen = parsed
+	}
+	s := &sighting{
+		RFIDUID:     strings.ToUpper(req.RFIDUID),
+		Count:       1,
+		FirstSeen:   seen,
+		LastSeen:    seen,
+		DeviceID:    req.DeviceID,
+		EventID:     req.EventID,
+		TS:          req.TS,
+		AdmissionNo: req.AdmissionNo,
+		GateID:      req.GateID,
+	}
+
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	if cur, ok := a.pending[s.RFIDUID]; ok {
+		cur.merge(s)
+	} else if len(a.pending) < maxSightingUIDs {
+		a.pending[s.RFIDUID] = s
+	} else {
+		atomic.AddInt64(&a.Dropped, 1)
+		return
+	}
+	atomic.AddInt64(&a.Recorded, 1)
+}
+
+// Pending is the number of UIDs waiting for the next flush.
+func (a *SightingAggregator) Pending() int {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	return len(a.pending)
+}
+
+// take swaps out the pending set.
+func (a *SightingAggregator) take() []*sighting {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	if len(a.pending) == 0 {
+		return nil
+	}
+	rows := make([]*sighting, 0, len(a.pending))
+	for _, s := range a.pending {
+		rows = append(rows, s)
+	}
+	a.pending = make(map[string]*sighting, len(rows))
+	return rows
+}
+
+// restore merges rows from a failed flush back in. The pending set may then
+// hold up to twice maxSightingUIDs, which the next flush clears.
+func (a *SightingAggregator) restore(rows []*sighting) {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	for _, s := range rows {
+		if cur, ok := a.pending[s.RFIDUID]; ok {
+			s.merge(cur)
+		}
+		a.pending[s.RFIDUID] = s
+	}
+}
+
+// Flush writes everything pending. On error the rows are kept for the next
+// attempt.
+func (a *SightingAggregator) Flush() error {
+	rows := a.take()
+	if len(rows) == 0 {
+		return nil
+	}
+	a.admission.WaitDB()
+	err := a.write(rows)
+	a.admission.ReleaseDB()
+	atomic.AddInt64(&a.Flushes, 1)
+	if err != nil {
+		atomic.AddInt64(&a.FlushErrors, 1)
+		a.restore(rows)
+	}
+	return err
+}
+
+func (a *SightingAggregator) write(rows []*sighting) error {
+	payload, err := json.Marshal(rows)
+	if err != nil {
+		return err
+	}
+	// Cards registered since they were seen are skipped; register-rfid has
+	// already removed their row.
+	_, err = a.db.Exec(upsertUnassigned(
+		`SELECT e.rfid_uid, e.first_seen, e.last_seen, e.count, e.device_id,
+		        jsonb_strip_nulls(jsonb_build_object('event_id', e.event_id, 'device_id', e.device_id, 'ts', e.ts,
+		                                             'admission_no', e.admission_no, 'gate_id', e.gate_id))
+		 FROM jsonb_to_recordset($1::jsonb) AS e(rfid_uid text, count int, first_seen timestamptz, last_seen timestamptz,
+		                                         device_id text, event_id text, ts text, admission_no text, gate_id text)
+		 WHERE NOT EXISTS (SELECT 1 FROM students s WHERE s.rfid_uid = e.rfid_uid)`),
+		string(payload),
+	)
+	return err
+}
+
+// upsertUnassigned wraps a query yielding (rfid_uid, first_seen, last_seen,
+// seen_count, device_id, last_event) rows in an upsert into rfid_unassigned.
+// Counts add up and the seen range widens; device_id and last_event follow
+// whichever side was seen last, so a batch that arrives late (a retried
+// flush, a summary held while offline) does not overwrite a newer sighting.
+func upsertUnassigned(rows string) string {
+	return `INSERT INTO rfid_unassigned (rfid_uid, first_seen, last_seen, seen_count, device_id, last_event)
+		 ` + rows + `
+		 ON CONFLICT (rfid_uid) DO UPDATE
+		   SET first_seen = LEAST(rfid_unassigned.first_seen, EXCLUDED.first_seen),
+		       last_seen = GREATEST(rfid_unassigned.last_seen, EXCLUDED.last_seen),
+		       seen_count = rfid_unassigned.seen_count + EXCLUDED.seen_count,
+		       device_id = CASE WHEN EXCLUDED.last_seen >= rfid_unassigned.last_seen
+		                        THEN EXCLUDED.device_id ELSE rfid_unassigned.device_id END,
+		       last_event = CASE WHEN EXCLUDED.last_seen >= rfid_unassigned.last_seen
+		                         THEN EXCLUDED.last_event ELSE rfid_unassigned.last_event END`
+}
+
+// Run flushes every interval until Close.
+func (a *SightingAggregator) Run() {
+	defer close(a.done)
+	ticker := time.NewTicker(a.interval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-ticker.C:
+		case <-a.stop:
+			return
+		}
+		if err := a.Flush(); err != nil {
+			log.Printf("Failed to flush %d unassigned RFID sighting(s): %v", a.Pending(), err)
+		}
+	}
+}
+
+// Close stops Run and makes a final flush.
+func (a *SightingAggregator) Close() {
+	close(a.stop)
+	<-a.done
+	if err := a.Flush(); err != nil {
+		log.Printf("Lost %d unassigned RFID sighting(s) at shutdown: %v", a.Pending(), err)
+	}
+}
@@ -0,0 +1,170 @@
+package main
+
+import (
+	"encoding/json"
+	"log"
+	"net/http"
+	"strings"
+	"time"
+)
+
+// UnknownCardSummary is a device's batched report of taps by cards that its
+// registered-UID filter rejected. Devices send it every minute or so instead
+// of one event per tap.
+type UnknownCardSummary struct {
+	Entries []UnknownCardEntry `json:"entries"`
+	Dropped int                `json:"dropped,omitempty"` // taps the device could not fit in the summary
+}
+
+type UnknownCardEntry struct {
+	RFIDUID   string `json:"rfid_uid"`
+	Count     int    `json:"count"`
+	FirstSeen string `json:"first_seen"`
+	LastSeen  string `json:"last_seen"`
+}
+
+const maxSummaryEntries = 256
+
+func (g *Gateway) unknownSummaryHandler(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		w.WriteHeader(http.StatusMethodNotAllowed)
+		return
+	}
+
+	deviceToken := r.Header.Get("X-Device-Token")
+	if deviceToken == "" {
+		w.WriteHeader(http.StatusUnauthorized)
+		json.NewEncoder(w).Encode(map[string]string{"error": "missing X-Device-Token"})
+		return
+	}
+	deviceID, err := g.authenticateDevice(deviceToken)
+	if err != nil {
+		w.WriteHeader(http.StatusUnauthorized)
+		json.NewEncoder(w).Encode(map[string]string{"error": "invalid device token"})
+		return
+	}
+
+	if ok, wait := g.admission.Allow(deviceID); !ok {
+		writeTooManyRequests(w, wait)
+		return
+	}
+
+	var summary UnknownCardSummary
+	if err := json.NewDecoder(r.Body).Decode(&summary); err != nil || len(summary.Entries) > maxSummaryEntries {
+		w.WriteHeader(http.StatusBadRequest)
+		json.NewEncoder(w).Encode(map[string]string{"error": "invalid summary"})
+		return
+	}
+
+	if !g.admission.AcquireDB(r.Context()) {
+		writeTooManyRequests(w, time.Second)
+		return
+	}
+	registered, err := g.recordUnknownSummary(deviceID, summary)
+	g.admission.ReleaseDB()
+	if err != nil {
+		log.Printf("Failed to record unknown-card summary from %s: %v", deviceID, err)
+		w.WriteHeader(http.StatusInternalServerError)
+		return
+	}
+	if summary.Dropped > 0 {
+		log.Printf("Device %s dropped %d unknown-card tap(s) from its summary", deviceID, summary.Dropped)
+	}
+
+	// UIDs registered since the device last fetched its filter; it refreshes
+	// the filter when this is non-empty.
+	if registered == nil {
+		registered = []string{}
+	}
+	w.Header().Set("Content-Type", "application/json")
+	json.NewEncoder(w).Encode(map[string]any{"registered": registered})
+}
+
+type summaryRow struct {
+	RFIDUID   string    `json:"rfid_uid"`
+	Count     int       `json:"count"`
+	FirstSeen time.Time `json:"first_seen"`
+	LastSeen  time.Time `json:"last_seen"`
+}
+
+// recordUnknownSummary folds a summary into rfid_unassigned with one
+// multi-row upsert and returns the UIDs that are in fact registered.
+func (g *Gateway) recordUnknownSummary(deviceID string, summary UnknownCardSummary) ([]string, error) {
+	now := time.Now()
+	merged := make(map[string]*summaryRow, len(summary.Entries))
+	uids := make([]string, 0, len(summary.Entries))
+	for _, e := range summary.Entries {
+		uid := strings.ToUpper(e.RFIDUID)
+		if uid == "" || len(uid) > 20 || e.Count <= 0 {
+			continue
+		}
+		first, _ := plausibleTS(e.FirstSeen, now)
+		last, _ := plausibleTS(e.LastSeen, now)
+		row, ok := merged[uid]
+		if !ok {
+			row = &summaryRow{RFIDUID: uid, FirstSeen: first, LastSeen: last}
+			merged[uid] = row
+			uids = append(uids, uid)
+		}
+		row.Count += e.Count
+		if first.Before(row.FirstSeen) {
+			row.FirstSeen = first
+		}
+		if last.After(row.LastSeen) {
+			row.LastSeen = last
+		}
+	}
+	if len(uids) == 0 {
+		return nil, nil
+	}
+
+	rows := make([]*summaryRow, 0, len(uids))
+	for _, uid := range uids {
+		rows = append(rows, merged[uid])
+	}
+	payload, err := json.Marshal(rows)
+	if err != nil {
+		return nil, err
+	}
+
+	tx, err := g.db.Begin()
+	if err != nil {
+		return nil, err
+	}
+	defer tx.Rollback()
+
+	// A stale filter on the device can report a card registered since.
+	var registered []string
+	res, err := tx.Query(
+		`SELECT s.rfid_uid FROM students s
+		 JOIN jsonb_to_recordset($1::jsonb) AS e(rfid_uid text) ON s.rfid_uid = e.rfid_uid`,
+		string(payload),
+	)
+	if err != nil {
+		return nil, err
+	}
+	for res.Next() {
+		var uid string
+		if err := res.Scan(&uid); err != nil {
+			res.Close()
+			return nil, err
+		}
+		registered = append(registered, uid)
+	}
+	res.Close()
+	if err := res.Err(); err != nil {
+		return nil, err
+	}
+
+	_, err = tx.Exec(upsertUnassigned(
+		`SELECT e.rfid_uid, e.first_seen, e.last_seen, e.count, $2,
+		        jsonb_build_object('device_id', $2::text, 'ts', e.last_seen, 'source', 'summary', 'count', e.count)
+		 FROM jsonb_to_recordset($1::jsonb) AS e(rfid_uid text, count int, first_seen timestamptz, last_seen timestamptz)
+		 WHERE NOT EXISTS (SELECT 1 FROM students s WHERE s.rfid_uid = e.rfid_uid)`),
+		string(payload), deviceID,
+	)
+	if err != nil {
+		return nil, err
+	}
+	return registered, tx.Commit()
+}
@@ -25,6 +25,7 @@ export interface AttendanceRecord {
   event_type: 'entry' | 'exit';
   ts: string;
   device_id?: string;
+  processed_at?: string;
   name?: string;
 }
 
@@ -35,6 +36,13 @@ export interface AttendanceEvent {
   event_type: 'entry' | 'exit';
   ts: string;
   device_id?: string;
+  gate_id?: string;
+}
+
+// The gateway pushes events in small batches; single events are still accepted.
+interface AttendanceBatchMessage {
+  type: 'attendance_batch';
+  events: AttendanceEvent[];
 }
 
 // API Client
@@ -99,11 +107,20 @@ export async function fetchAttendance(params?: {
   date?: string;
   admission_no?: string;
   limit?: number;
+  // Keyset cursor: the ts and id of the last row of the previous page.
+  before?: { ts: string; id: number };
+  // Rows written after this time, oldest first, instead of newest by ts.
+  updated_since?: string;
 }): Promise<AttendanceRecord[]> {
   const searchParams = new URLSearchParams();
   if (params?.date) searchParams.set('date', params.date);
   if (params?.admission_no) searchParams.set('admission_no', params.admission_no);
   if (params?.limit) searchParams.set('limit', params.limit.toString());
+  if (params?.before) {
+    searchParams.set('before_ts', params.before.ts);
+    searchParams.set('before_id', params.before.id.toString());
+  }
+  if (params?.updated_since) searchParams.set('updated_since', params.updated_since);
 
   const query = searchParams.toString();
   const url = query ? `${API_URL}/attendance?${query}` : `${API_URL}/attendance`;
@@ -112,23 +129,88 @@ export async function fetchAttendance(params?: {
   return res.json();
 }
 
+// processed_at is the writing transaction's start time, so a row can commit
+// after a newer-looking one has been read; ask again from a little earlier.
+const ATTENDANCE_FEED_OVERLAP_MS = 5000;
+const ATTENDANCE_FEED_PAGE = 200;
+
+function compareNewestFirst(a: AttendanceRecord, b: AttendanceRecord): number {
+  const dt = Date.parse(b.ts) - Date.parse(a.ts);
+  return dt !== 0 ? dt : b.id - a.id;
+}
+
+/**
+ * Holds the newest `size` attendance rows and keeps them current. The first
+ * refresh loads them; later refreshes fetch only rows written since the
+ * newest processed_at seen and merge them in by id. A burst larger than one
+ * page falls back to a full load.
+ */
+export class AttendanceFeed {
+  private size: number;
+  private rows: AttendanceRecord[] = [];
+  private since: string | null = null;
+
+  constructor(size: number) {
+    this.size = size;
+  }
+
+  async refresh(): Promise<AttendanceRecord[]> {
+    if (this.since === null) {
+      this.rows = await fetchAttendance({ limit: this.size });
+      this.advance(this.rows);
+      return this.rows;
+    }
+
+    const from = new Date(Date.parse(this.since) - ATTENDANCE_FEED_OVERLAP_MS).toISOString();
+    const changed = await fetchAttendance({ updated_since: from, limit: ATTENDANCE_FEED_PAGE });
+    if (changed.length >= ATTENDANCE_FEED_PAGE) {
+      this.since = null;
+      return this.refresh();
+    }
+    if (changed.length > 0) {
+      const byId = new Map(this.rows.map((row): [number, AttendanceRecord] => [row.id, row]));
+      for (const row of changed) byId.set(row.id, row);
+      this.rows = Array.from(byId.values()).sort(compareNewestFirst).slice(0, this.size);
+      this.advance(changed);
+    }
+    return this.rows;
+  }
+
+  private advance(rows: AttendanceRecord[]) {
+    for (const row of rows) {
+      if (row.processed_at && (this.since === null || Date.parse(row.processed_at) > Date.parse(this.since))) {
+        this.since = row.processed_at;
+      }
+    }
+  }
+}
+
+export interface AnalyticsSummary {
+  inside: number;
+  today_entries: number;
+  today_exits: number;
+}
+
+const localTimeZone = () => Intl.DateTimeFormat().resolvedOptions().timeZone || 'UTC';
+
+export async function fetchAnalyticsSummary(): Promise<AnalyticsSummary> {
+  const res = await fetch(`${API_URL}/analytics/summary?tz=${encodeURIComponent(localTimeZone())}`);
+  if (!res.ok) throw new Error('Failed to fetch analytics summary');
+  return res.json();
+}
+
 export async function getStats(): Promise<{
   totalStudents: number;
   todayCheckIns: number;
 }> {
-  const [students, attendance] = await Promise.all([
+  const [students, summary] = await Promise.all([
     fetchStudents(),
-    fetchAttendance({ limit: 1000 }),
+    fetchAnalyticsSummary(),
   ]);
 
-  const today = new Date().toISOString().split('T')[0];
-  const todayCheckIns = attendance.filter(
-    (record) => record.ts.startsWith(today) && record.event_type === 'entry'
-  ).length;
-
   return {
     totalStudents: students.length,
-    todayCheckIns,
+    todayCheckIns: summary.today_entries,
   };
 }
 
@@ -165,6 +247,7 @@ export async function fetchCurrentAttendance(): Promise<CurrentAttendance[]> {
 export class AttendanceWebSocket {
   private ws: WebSocket | null = null;
   private listeners: Set<(event: AttendanceEvent) => void> = new Set();
+  private batchListeners: Set<(events: AttendanceEvent[]) => void> = new Set();
   private reconnectAttempts = 0;
   private maxReconnectAttempts = 5;
 
@@ -181,8 +264,13 @@ export class AttendanceWebSocket {
 
       this.ws.onmessage = (event) => {
         try {
-          const data: AttendanceEvent = JSON.parse(event.data);
-          this.listeners.forEach((listener) => listener(data));
+          const data: AttendanceEvent | AttendanceBatchMessage = JSON.parse(event.data);
+          const events = data.type === 'attendance_batch'
+            ? (data as AttendanceBatchMessage).events
+            : [data as AttendanceEvent];
+          if (events.length === 0) return;
+          events.forEach((e) => this.listeners.forEach((listener) => listener(e)));
+          this.batchListeners.forEach((listener) => listener(events));
         } catch (err) {
           console.error('Failed to parse WebSocket message:', err);
         }
@@ -216,11 +304,19 @@ export class AttendanceWebSocket {
       this.ws = null;
     }
     this.listeners.clear();
+    this.batchListeners.clear();
   }
 
   onEvent(listener: (event: AttendanceEvent) => void) {
     this.listeners.add(listener);
     return () => this.listeners.delete(listener);
   }
+
+  // Called once per message with every event it carried, for consumers that
+  // refetch on change and should do so once per batch rather than per event.
+  onEvents(listener: (events: AttendanceEvent[]) => void) {
+    this.batchListeners.add(listener);
+    return () => this.batchListeners.delete(listener);
+  }
 }
 
@@ -0,0 +1,73 @@
+-- Rollup tables maintained by the gateway in the same transaction as each
+-- attendance insert, so dashboards read O(buckets) rows instead of scanning
+-- attendance. Buckets are UTC; students without a branch/year roll up under
+-- '' / 0.
+
+CREATE TABLE IF NOT EXISTS occupancy_rollup (
+  branch TEXT NOT NULL DEFAULT '',
+  year INT NOT NULL DEFAULT 0,
+  inside INT NOT NULL DEFAULT 0,
+  updated_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+  PRIMARY KEY (branch, year)
+);
+
+CREATE TABLE IF NOT EXISTS attendance_hourly (
+  bucket TIMESTAMPTZ NOT NULL,  -- date_trunc('hour', ts, 'UTC')
+  branch TEXT NOT NULL DEFAULT '',
+  year INT NOT NULL DEFAULT 0,
+  entries INT NOT NULL DEFAULT 0,
+  exits INT NOT NULL DEFAULT 0,
+  PRIMARY KEY (bucket, branch, year)
+);
+
+CREATE TABLE IF NOT EXISTS attendance_daily (
+  day DATE NOT NULL,            -- UTC date
+  branch TEXT NOT NULL DEFAULT '',
+  year INT NOT NULL DEFAULT 0,
+  entries INT NOT NULL DEFAULT 0,
+  exits INT NOT NULL DEFAULT 0,
+  PRIMARY KEY (day, branch, year)
+);
+
+-- Recompute occupancy from attendance_state, e.g. after students change
+-- branch or year. The lock is taken before attendance_state is read, so
+-- gateway transactions still in flight apply their delta on top of the
+-- rebuilt counts instead of being counted twice.
+CREATE OR REPLACE FUNCTION rebuild_occupancy_rollup() RETURNS void AS $$
+BEGIN
+  LOCK TABLE occupancy_rollup IN SHARE ROW EXCLUSIVE MODE;
+  DELETE FROM occupancy_rollup;
+  INSERT INTO occupancy_rollup (branch, year, inside)
+  SELECT COALESCE(s.branch, ''), COALESCE(s.year, 0), count(*)
+  FROM attendance_state st
+  JOIN students s ON s.admission_no = st.admission_no
+  WHERE st.last_event_type = 'entry'
+  GROUP BY 1, 2;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Backfill from existing data on first run only.
+DO $$
+BEGIN
+  IF NOT EXISTS (SELECT 1 FROM attendance_hourly) THEN
+    INSERT INTO attendance_hourly (bucket, branch, year, entries, exits)
+    SELECT date_trunc('hour', a.ts, 'UTC'), COALESCE(s.branch, ''), COALESCE(s.year, 0),
+           count(*) FILTER (WHERE a.event_type = 'entry'),
+           count(*) FILTER (WHERE a.event_type = 'exit')
+    FROM attendance a
+    JOIN students s ON s.admission_no = a.admission_no
+    GROUP BY 1, 2, 3;
+  END IF;
+
+  IF NOT EXISTS (SELECT 1 FROM attendance_daily) THEN
+    INSERT INTO attendance_daily (day, branch, year, entries, exits)
+    SELECT (bucket AT TIME ZONE 'UTC')::date, branch, year, sum(entries), sum(exits)
+    FROM attendance_hourly
+    GROUP BY 1, 2, 3;
+  END IF;
+
+  IF NOT EXISTS (SELECT 1 FROM occupancy_rollup) THEN
+    PERFORM rebuild_occupancy_rollup();
+  END IF;
+END;
+$$;
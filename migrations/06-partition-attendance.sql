@@ -0,0 +1,159 @@
+-- Monthly range partitioning for attendance and events_raw.
+--
+-- Partitions cover UTC months and are named <table>_pYYYYMM; a <table>_default
+-- partition catches rows outside the created range. Unique constraints on a
+-- partitioned table must include the partition key, so the keys become
+-- (id, ts) and (event_id, ts); the gateway normalises ts before an event is
+-- written or buffered so retries carry the same key.
+--
+-- The gateway calls ensure_attendance_partitions() on startup and every few
+-- hours, and prune_events_raw_partitions() when EVENTS_RAW_RETENTION_MONTHS
+-- is set.
+
+-- Create the partition for one month, moving any rows that already landed in
+-- the default partition (ATTACH refuses while they are there).
+CREATE OR REPLACE FUNCTION create_month_partition(parent TEXT, month DATE) RETURNS BOOLEAN AS $$
+DECLARE
+  part TEXT := format('%s_p%s', parent, to_char(month, 'YYYYMM'));
+  dflt TEXT := parent || '_default';
+  lo TIMESTAMPTZ := date_trunc('month', month::timestamp) AT TIME ZONE 'UTC';
+  hi TIMESTAMPTZ := (date_trunc('month', month::timestamp) + interval '1 month') AT TIME ZONE 'UTC';
+BEGIN
+  IF to_regclass(part) IS NOT NULL THEN
+    RETURN false;
+  END IF;
+  EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS)', part, parent);
+  IF to_regclass(dflt) IS NOT NULL THEN
+    EXECUTE format(
+      'WITH moved AS (DELETE FROM %I WHERE ts >= $1 AND ts < $2 RETURNING *) INSERT INTO %I SELECT * FROM moved',
+      dflt, part) USING lo, hi;
+  END IF;
+  EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)', parent, part, lo, hi);
+  RETURN true;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Make sure the current month and the next months_ahead months exist.
+CREATE OR REPLACE FUNCTION ensure_attendance_partitions(months_ahead INT DEFAULT 3) RETURNS INT AS $$
+DECLARE
+  parent TEXT;
+  created INT := 0;
+BEGIN
+  FOREACH parent IN ARRAY ARRAY['attendance', 'events_raw'] LOOP
+    FOR i IN 0..months_ahead LOOP
+      IF create_month_partition(parent,
+           (date_trunc('month', now() AT TIME ZONE 'UTC') + make_interval(months => i))::date) THEN
+        created := created + 1;
+      END IF;
+    END LOOP;
+  END LOOP;
+  RETURN created;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Detach (and by default drop) events_raw partitions older than keep_months
+-- full months. attendance is kept; the rollups summarise it anyway.
+CREATE OR REPLACE FUNCTION prune_events_raw_partitions(keep_months INT, drop_detached BOOLEAN DEFAULT true)
+RETURNS SETOF TEXT AS $$
+DECLARE
+  cutoff TEXT := to_char(date_trunc('month', now() AT TIME ZONE 'UTC') - make_interval(months => GREATEST(keep_months, 1)), 'YYYYMM');
+  part TEXT;
+BEGIN
+  FOR part IN
+    SELECT c.relname
+    FROM pg_inherits i
+    JOIN pg_class c ON c.oid = i.inhrelid
+    WHERE i.inhparent = 'events_raw'::regclass
+      AND c.relname ~ '^events_raw_p[0-9]{6}$'
+      AND substring(c.relname FROM '[0-9]{6}$') < cutoff
+    ORDER BY c.relname
+  LOOP
+    EXECUTE format('ALTER TABLE events_raw DETACH PARTITION %I', part);
+    IF drop_detached THEN
+      EXECUTE format('DROP TABLE %I', part);
+    END IF;
+    RETURN NEXT part;
+  END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+-- One-time conversion of the heap tables. Runs as a single transaction: on
+-- any error both tables are left as they were.
+DO $$
+DECLARE
+  first_month DATE;
+  m DATE;
+BEGIN
+  IF EXISTS (SELECT 1 FROM pg_partitioned_table WHERE partrelid = 'attendance'::regclass) THEN
+    RETURN;
+  END IF;
+
+  ALTER TABLE attendance RENAME TO attendance_unpartitioned;
+  ALTER TABLE events_raw RENAME TO events_raw_unpartitioned;
+  ALTER SEQUENCE attendance_id_seq OWNED BY NONE;
+  DROP INDEX IF EXISTS idx_attendance_adm_ts;
+  DROP INDEX IF EXISTS idx_attendance_ts;
+  DROP INDEX IF EXISTS idx_attendance_adm_ts_id;
+  DROP INDEX IF EXISTS idx_attendance_ts_id;
+  DROP INDEX IF EXISTS idx_events_raw_device_ts;
+
+  CREATE TABLE attendance (
+    id BIGINT NOT NULL DEFAULT nextval('attendance_id_seq'),
+    event_id UUID,
+    admission_no TEXT REFERENCES students(admission_no),
+    event_type TEXT NOT NULL,  -- 'entry' | 'exit'
+    ts TIMESTAMPTZ NOT NULL,
+    device_id TEXT,
+    processed_at TIMESTAMPTZ DEFAULT now(),
+    CONSTRAINT attendance_id_ts_pkey PRIMARY KEY (id, ts),
+    CONSTRAINT attendance_event_id_ts_key UNIQUE (event_id, ts)
+  ) PARTITION BY RANGE (ts);
+  ALTER SEQUENCE attendance_id_seq OWNED BY attendance.id;
+
+  CREATE TABLE events_raw (
+    event_id UUID NOT NULL,
+    device_id TEXT NOT NULL REFERENCES device_registry(device_id),
+    admission_no TEXT NOT NULL REFERENCES students(admission_no),
+    ts TIMESTAMPTZ NOT NULL,
+    raw_json JSONB,
+    created_at TIMESTAMPTZ DEFAULT now(),
+    CONSTRAINT events_raw_event_id_ts_pkey PRIMARY KEY (event_id, ts)
+  ) PARTITION BY RANGE (ts);
+
+  -- attendance's B-trees on (ts, id) come from 07-search-and-cursor-indexes.sql,
+  -- which runs next. events_raw is only ever read by range, so BRIN is
+  -- enough there.
+  CREATE INDEX idx_events_raw_device_ts ON events_raw (device_id, ts DESC);
+  CREATE INDEX idx_events_raw_ts_brin ON events_raw USING brin (ts);
+
+  CREATE TABLE attendance_default PARTITION OF attendance DEFAULT;
+  CREATE TABLE events_raw_default PARTITION OF events_raw DEFAULT;
+
+  -- Partitions for the existing data, up to three years back; anything
+  -- older stays in the default partition.
+  SELECT date_trunc('month', min(ts) AT TIME ZONE 'UTC')::date INTO first_month
+  FROM (SELECT ts FROM attendance_unpartitioned UNION ALL SELECT ts FROM events_raw_unpartitioned) t;
+  first_month := GREATEST(
+    COALESCE(first_month, date_trunc('month', now() AT TIME ZONE 'UTC')::date),
+    (date_trunc('month', now() AT TIME ZONE 'UTC') - interval '36 months')::date);
+  m := first_month;
+  WHILE m < date_trunc('month', now() AT TIME ZONE 'UTC')::date LOOP
+    PERFORM create_month_partition('attendance', m);
+    PERFORM create_month_partition('events_raw', m);
+    m := (m + interval '1 month')::date;
+  END LOOP;
+  PERFORM ensure_attendance_partitions(3);
+
+  INSERT INTO attendance (id, event_id, admission_no, event_type, ts, device_id, processed_at)
+  SELECT id, event_id, admission_no, event_type, ts, device_id, processed_at FROM attendance_unpartitioned;
+  INSERT INTO events_raw (event_id, device_id, admission_no, ts, raw_json, created_at)
+  SELECT event_id, device_id, admission_no, ts, raw_json, created_at FROM events_raw_unpartitioned;
+  PERFORM setval('attendance_id_seq', COALESCE((SELECT max(id) FROM attendance), 0) + 1, false);
+
+  DROP TABLE attendance_unpartitioned;
+  DROP TABLE events_raw_unpartitioned;
+END;
+$$;
+
+ANALYZE attendance;
+ANALYZE events_raw;
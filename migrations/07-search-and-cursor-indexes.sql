@@ -0,0 +1,22 @@
+-- Indexes behind GET /students?search= and the cursors on GET /attendance.
+
+-- Trigram GIN indexes let the ILIKE '%term%' student search use an index
+-- instead of scanning students. Terms shorter than three characters have no
+-- trigrams and still scan.
+CREATE EXTENSION IF NOT EXISTS pg_trgm;
+CREATE INDEX IF NOT EXISTS idx_students_name_trgm ON students USING gin (name gin_trgm_ops);
+CREATE INDEX IF NOT EXISTS idx_students_admission_no_trgm ON students USING gin (admission_no gin_trgm_ops);
+
+-- Attendance pages are ordered by (ts, id) so a page boundary is exact
+-- even when several events share a timestamp; the keyset cursor
+-- (before_ts, before_id) is then a single index range. These replace the
+-- ts-only indexes older databases still have; attendance.sql creates the
+-- same two on a fresh one.
+CREATE INDEX IF NOT EXISTS idx_attendance_ts_id ON attendance (ts DESC, id DESC);
+CREATE INDEX IF NOT EXISTS idx_attendance_adm_ts_id ON attendance (admission_no, ts DESC, id DESC);
+DROP INDEX IF EXISTS idx_attendance_ts;
+DROP INDEX IF EXISTS idx_attendance_adm_ts;
+
+-- updated_since returns rows by when the gateway wrote them, which for
+-- events buffered on a device or in the gateway can be long after their ts.
+CREATE INDEX IF NOT EXISTS idx_attendance_processed_at ON attendance (processed_at, id);
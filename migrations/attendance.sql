@@ -40,7 +40,9 @@ CREATE TABLE IF NOT EXISTS attendance_state (
   last_ts TIMESTAMPTZ
 );
 
-CREATE INDEX IF NOT EXISTS idx_attendance_adm_ts ON attendance(admission_no, ts DESC);
+-- Same names and keys as 07-search-and-cursor-indexes.sql, so re-running
+-- this file on an existing database builds nothing.
+CREATE INDEX IF NOT EXISTS idx_attendance_adm_ts_id ON attendance(admission_no, ts DESC, id DESC);
 CREATE INDEX IF NOT EXISTS idx_events_raw_device_ts ON events_raw(device_id, ts DESC);
-CREATE INDEX IF NOT EXISTS idx_attendance_ts ON attendance(ts DESC);
+CREATE INDEX IF NOT EXISTS idx_attendance_ts_id ON attendance(ts DESC, id DESC);
 
@@ -0,0 +1,188 @@
+#!/usr/bin/env bash
+#
+# Compares the attendance table as a single heap (the layout before
+# migrations/06-partition-attendance.sql) with monthly range partitions,
+# using a year of synthetic events in a scratch schema. The real tables are
+# not touched; the schema is dropped at the end unless KEEP=1.
+#
+#   ./scripts/bench-partitioning.sh                     # dev database via docker compose
+#   PG_URL=postgres://... ROWS=10000000 ./scripts/bench-partitioning.sh
+
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+cd "$ROOT_DIR"
+
+ROWS="${ROWS:-5000000}"
+STUDENTS="${STUDENTS:-5000}"
+RUNS="${RUNS:-7}"
+KEEP="${KEEP:-0}"
+
+run_psql() {
+  if [[ -n "${PG_URL:-}" ]]; then
+    psql "${PG_URL}" -v ON_ERROR_STOP=1 -q "$@"
+  elif command -v docker-compose >/dev/null 2>&1; then
+    docker-compose -f docker-compose.dev.yml exec -T postgres psql -v ON_ERROR_STOP=1 -q -U attendance_user -d attendance "$@"
+  else
+    docker compose -f docker-compose.dev.yml exec -T postgres psql -v ON_ERROR_STOP=1 -q -U attendance_user -d attendance "$@"
+  fi
+}
+
+echo "Loading ${ROWS} synthetic events for ${STUDENTS} students over 365 days (twice)..."
+
+run_psql -v rows="${ROWS}" -v students="${STUDENTS}" -v runs="${RUNS}" <<'SQL'
+\set QUIET on
+DROP SCHEMA IF EXISTS bench_partitioning CASCADE;
+CREATE SCHEMA bench_partitioning;
+SET search_path = bench_partitioning, public;
+SELECT set_config('bench.rows', :'rows', false) AS _rows,
+       set_config('bench.students', :'students', false) AS _students,
+       set_config('bench.runs', :'runs', false) AS _runs \gset
+
+-- Before: one heap with B-tree indexes, as created by attendance.sql.
+CREATE TABLE att_heap (
+  id BIGSERIAL PRIMARY KEY,
+  event_id UUID UNIQUE,
+  admission_no TEXT,
+  event_type TEXT NOT NULL,
+  ts TIMESTAMPTZ NOT NULL,
+  device_id TEXT,
+  processed_at TIMESTAMPTZ DEFAULT now()
+);
+
+-- After: the layout from 06-partition-attendance.sql.
+CREATE TABLE att_part (
+  id BIGINT NOT NULL,
+  event_id UUID,
+  admission_no TEXT,
+  event_type TEXT NOT NULL,
+  ts TIMESTAMPTZ NOT NULL,
+  device_id TEXT,
+  processed_at TIMESTAMPTZ DEFAULT now(),
+  PRIMARY KEY (id, ts),
+  UNIQUE (event_id, ts)
+) PARTITION BY RANGE (ts);
+CREATE TABLE att_part_default PARTITION OF att_part DEFAULT;
+
+DO $$
+DECLARE
+  m DATE := (date_trunc('month', now() AT TIME ZONE 'UTC') - interval '12 months')::date;
+BEGIN
+  WHILE m <= (date_trunc('month', now() AT TIME ZONE 'UTC') + interval '1 month')::date LOOP
+    EXECUTE format('CREATE TABLE %I PARTITION OF att_part FOR VALUES FROM (%L) TO (%L)',
+      'att_part_p' || to_char(m, 'YYYYMM'),
+      m::timestamp AT TIME ZONE 'UTC',
+      (m + interval '1 month')::timestamp AT TIME ZONE 'UTC');
+    m := (m + interval '1 month')::date;
+  END LOOP;
+END;
+$$;
+
+-- Events arrive roughly in time order, as they do from the gateway.
+INSERT INTO att_heap (event_id, admission_no, event_type, ts, device_id)
+SELECT gen_random_uuid(),
+       'S' || lpad((1 + (g * 7919) % current_setting('bench.students')::int)::text, 5, '0'),
+       CASE WHEN g % 2 = 0 THEN 'entry' ELSE 'exit' END,
+       now() - interval '365 days' + (g::float8 / current_setting('bench.rows')::int) * interval '365 days',
+       'bench-device-' || (g % 4)
+FROM generate_series(1, current_setting('bench.rows')::int) g;
+
+INSERT INTO att_part (id, event_id, admission_no, event_type, ts, device_id, processed_at)
+SELECT id, event_id, admission_no, event_type, ts, device_id, processed_at FROM att_heap;
+
+CREATE INDEX ON att_heap (admission_no, ts DESC);
+CREATE INDEX ON att_heap (ts DESC);
+CREATE INDEX ON att_part (admission_no, ts DESC);
+CREATE INDEX ON att_part (ts DESC);
+ANALYZE att_heap;
+ANALYZE att_part;
+
+CREATE FUNCTION time_query(q TEXT) RETURNS NUMERIC AS $$
+DECLARE
+  t0 TIMESTAMPTZ;
+  samples NUMERIC[] := '{}';
+BEGIN
+  EXECUTE q; -- warm the cache
+  FOR i IN 1..current_setting('bench.runs')::int LOOP
+    t0 := clock_timestamp();
+    EXECUTE q;
+    samples := samples || (extract(epoch FROM clock_timestamp() - t0) * 1000)::numeric;
+  END LOOP;
+  RETURN (SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY s) FROM unnest(samples) s)::numeric(10, 2);
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE FUNCTION partitions_scanned(q TEXT) RETURNS INT AS $$
+DECLARE
+  line TEXT;
+  parts TEXT[] := '{}';
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || q LOOP
+    IF line !~ 'never executed' AND line ~ ' on att_part_(p\d{6}|default)\M' THEN
+      parts := parts || substring(line FROM ' on (att_part_(p\d{6}|default))\M');
+    END IF;
+  END LOOP;
+  RETURN (SELECT count(DISTINCT p) FROM unnest(parts) p);
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE results (query TEXT, heap_ms NUMERIC, partitioned_ms NUMERIC, partitions INT);
+
+DO $$
+DECLARE
+  bench_day TEXT := to_char(now() - interval '100 days', 'YYYY-MM-DD');
+  month_start TEXT := to_char(date_trunc('month', now() - interval '100 days'), 'YYYY-MM-DD');
+  cols TEXT := 'SELECT a.id, a.admission_no, a.event_type, a.ts, a.device_id FROM ';
+  q_heap TEXT;
+  q_part TEXT;
+  t0 TIMESTAMPTZ;
+  heap_ms NUMERIC;
+BEGIN
+  -- GET /attendance?date=: DATE(ts) = before, half-open range after.
+  q_heap := cols || format('att_heap a WHERE DATE(a.ts) = %L ORDER BY a.ts DESC LIMIT 100', bench_day);
+  q_part := cols || format('att_part a WHERE a.ts >= %L::date AND a.ts < %L::date + 1 ORDER BY a.ts DESC LIMIT 100', bench_day, bench_day);
+  INSERT INTO results VALUES ('one day, latest 100', time_query(q_heap), time_query(q_part), partitions_scanned(q_part));
+
+  q_heap := format('SELECT count(*) FROM att_heap a WHERE DATE(a.ts) = %L', bench_day);
+  q_part := format('SELECT count(*) FROM att_part a WHERE a.ts >= %L::date AND a.ts < %L::date + 1', bench_day, bench_day);
+  INSERT INTO results VALUES ('one day, count', time_query(q_heap), time_query(q_part), partitions_scanned(q_part));
+
+  q_heap := format('SELECT event_type, count(*) FROM att_heap WHERE ts >= %L::date AND ts < %L::date + interval ''1 month'' GROUP BY 1', month_start, month_start);
+  q_part := replace(q_heap, 'att_heap', 'att_part');
+  INSERT INTO results VALUES ('one month, count by type', time_query(q_heap), time_query(q_part), partitions_scanned(q_part));
+
+  q_heap := format('SELECT ts, event_type FROM att_heap WHERE admission_no = %L AND ts >= %L::date AND ts < %L::date + interval ''1 month'' ORDER BY ts DESC', 'S00042', month_start, month_start);
+  q_part := replace(q_heap, 'att_heap', 'att_part');
+  INSERT INTO results VALUES ('one student, one month', time_query(q_heap), time_query(q_part), partitions_scanned(q_part));
+
+  q_heap := cols || 'att_heap a ORDER BY a.ts DESC LIMIT 100';
+  q_part := cols || 'att_part a ORDER BY a.ts DESC LIMIT 100';
+  INSERT INTO results VALUES ('latest 100 (dashboard)', time_query(q_heap), time_query(q_part), partitions_scanned(q_part));
+
+  -- Index maintenance on the write path: 100k new events this month.
+  t0 := clock_timestamp();
+  INSERT INTO att_heap (event_id, admission_no, event_type, ts, device_id)
+  SELECT gen_random_uuid(), 'S00001', 'entry', now() - (g || ' ms')::interval, 'bench-device-0'
+  FROM generate_series(1, 100000) g;
+  heap_ms := (extract(epoch FROM clock_timestamp() - t0) * 1000)::numeric(10, 2);
+  t0 := clock_timestamp();
+  INSERT INTO att_part (id, event_id, admission_no, event_type, ts, device_id)
+  SELECT -g, gen_random_uuid(), 'S00001', 'entry', now() - (g || ' ms')::interval, 'bench-device-0'
+  FROM generate_series(1, 100000) g;
+  INSERT INTO results VALUES ('insert 100k events', heap_ms,
+    (extract(epoch FROM clock_timestamp() - t0) * 1000)::numeric(10, 2), NULL);
+END;
+$$;
+
+\set QUIET off
+\echo
+SELECT pg_size_pretty(pg_total_relation_size('att_heap')) AS heap_size,
+       pg_size_pretty((SELECT sum(pg_total_relation_size(inhrelid)) FROM pg_inherits WHERE inhparent = 'att_part'::regclass)) AS partitioned_size,
+       (SELECT count(*) FROM pg_inherits WHERE inhparent = 'att_part'::regclass) AS partitions;
+SELECT query, heap_ms, partitioned_ms, round(heap_ms / NULLIF(partitioned_ms, 0), 1) AS speedup, partitions AS partitions_scanned
+FROM results;
+SQL
+
+if [[ "${KEEP}" != "1" ]]; then
+  run_psql -c "DROP SCHEMA bench_partitioning CASCADE" >/dev/null
+fi
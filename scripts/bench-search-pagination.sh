@@ -0,0 +1,230 @@
+#!/usr/bin/env bash
+#
+# Measures the queries behind GET /students?search= and GET /attendance
+# before and after migrations/07-search-and-cursor-indexes.sql, on synthetic
+# students and events in a scratch schema:
+#
+#   - student search: ILIKE '%term%' without and with the trigram indexes
+#   - deep attendance pages: LIMIT/OFFSET against the (before_ts, before_id)
+#     keyset cursor
+#   - a dashboard refresh: re-reading the newest 1000 rows against fetching
+#     only the rows written since the last refresh (updated_since)
+#
+# The real tables are not touched; the schema is dropped at the end unless
+# KEEP=1.
+#
+#   ./scripts/bench-search-pagination.sh               # dev database via docker compose
+#   PG_URL=postgres://... ROWS=1000000 ./scripts/bench-search-pagination.sh
+
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+cd "$ROOT_DIR"
+
+ROWS="${ROWS:-10000000}"
+STUDENTS="${STUDENTS:-100000}"
+RUNS="${RUNS:-7}"
+KEEP="${KEEP:-0}"
+
+run_psql() {
+  if [[ -n "${PG_URL:-}" ]]; then
+    psql "${PG_URL}" -v ON_ERROR_STOP=1 -q "$@"
+  elif command -v docker-compose >/dev/null 2>&1; then
+    docker-compose -f docker-compose.dev.yml exec -T postgres psql -v ON_ERROR_STOP=1 -q -U attendance_user -d attendance "$@"
+  else
+    docker compose -f docker-compose.dev.yml exec -T postgres psql -v ON_ERROR_STOP=1 -q -U attendance_user -d attendance "$@"
+  fi
+}
+
+echo "Loading ${STUDENTS} students and ${ROWS} synthetic events over 365 days..."
+
+run_psql -v rows="${ROWS}" -v students="${STUDENTS}" -v runs="${RUNS}" <<'SQL'
+\set QUIET on
+CREATE EXTENSION IF NOT EXISTS pg_trgm;
+DROP SCHEMA IF EXISTS bench_search CASCADE;
+CREATE SCHEMA bench_search;
+SET search_path = bench_search, public;
+SELECT set_config('bench.rows', :'rows', false) AS _rows,
+       set_config('bench.students', :'students', false) AS _students,
+       set_config('bench.runs', :'runs', false) AS _runs \gset
+
+CREATE TABLE students (
+  admission_no TEXT PRIMARY KEY,
+  name TEXT NOT NULL,
+  branch TEXT,
+  year INT,
+  rfid_uid TEXT UNIQUE,
+  created_at TIMESTAMPTZ DEFAULT now()
+);
+
+-- Names from 60 x 60 parts, so a surname fragment matches ~1/60 of students;
+-- a few names are one-offs, the case a search usually goes looking for.
+INSERT INTO students (admission_no, name, branch, year, created_at)
+SELECT format('%s%s%s', 2020 + g % 5, (ARRAY['CS','EC','ME','CE','EE'])[1 + g % 5], lpad(g::text, 6, '0')),
+       CASE WHEN g % 20000 = 7 THEN 'Zephyrine Quillfeather ' || g
+            ELSE (ARRAY['Aarav','Vivaan','Aditya','Vihaan','Arjun','Sai','Reyansh','Ayaan','Krishna','Ishaan',
+                        'Ananya','Diya','Aadhya','Saanvi','Pari','Anika','Navya','Myra','Sara','Ira',
+                        'Rohan','Kabir','Dev','Yash','Rahul','Kiran','Nikhil','Varun','Pranav','Manav',
+                        'Meera','Priya','Sneha','Pooja','Kavya','Riya','Tanvi','Nisha','Lakshmi','Divya',
+                        'Omar','Zain','Farhan','Imran','Yusuf','Aisha','Fatima','Zara','Noor','Sana',
+                        'John','Mary','Joseph','Anna','Thomas','Grace','David','Ruth','Paul','Esther'])[1 + g % 60]
+                 || ' ' ||
+                 (ARRAY['Sharma','Verma','Gupta','Kumar','Singh','Patel','Reddy','Nair','Menon','Iyer',
+                        'Rao','Das','Bose','Ghosh','Mukherjee','Banerjee','Chatterjee','Joshi','Kulkarni','Deshpande',
+                        'Pillai','Varghese','Mathew','Thomas','Kurian','Khan','Ahmed','Ali','Hussain','Sheikh',
+                        'Mehta','Shah','Desai','Jain','Agarwal','Bansal','Mittal','Goel','Saxena','Srivastava',
+                        'Mishra','Pandey','Tiwari','Dubey','Tripathi','Yadav','Chauhan','Rathore','Thakur','Bhat',
+                        'Hegde','Shetty','Kamath','Pai','Naik','Gowda','Murthy','Shastri','Acharya','Raghavan'])[1 + (g / 60) % 60]
+       END,
+       (ARRAY['CS','EC','ME','CE','EE'])[1 + g % 5],
+       1 + g % 4,
+       now() - (g || ' seconds')::interval
+FROM generate_series(1, current_setting('bench.students')::int) g;
+
+-- The layout from 06-partition-attendance.sql.
+CREATE TABLE attendance (
+  id BIGINT NOT NULL,
+  event_id UUID,
+  admission_no TEXT,
+  event_type TEXT NOT NULL,
+  ts TIMESTAMPTZ NOT NULL,
+  device_id TEXT,
+  processed_at TIMESTAMPTZ DEFAULT now(),
+  PRIMARY KEY (id, ts)
+) PARTITION BY RANGE (ts);
+CREATE TABLE attendance_default PARTITION OF attendance DEFAULT;
+
+DO $$
+DECLARE
+  m DATE := (date_trunc('month', now() AT TIME ZONE 'UTC') - interval '12 months')::date;
+BEGIN
+  WHILE m <= (date_trunc('month', now() AT TIME ZONE 'UTC') + interval '1 month')::date LOOP
+    EXECUTE format('CREATE TABLE %I PARTITION OF attendance FOR VALUES FROM (%L) TO (%L)',
+      'attendance_p' || to_char(m, 'YYYYMM'),
+      m::timestamp AT TIME ZONE 'UTC',
+      (m + interval '1 month')::timestamp AT TIME ZONE 'UTC');
+    m := (m + interval '1 month')::date;
+  END LOOP;
+END;
+$$;
+
+-- Events arrive roughly in time order and are written within a few seconds;
+-- one in 200 was buffered on a device or in the gateway and is written an
+-- hour or more late. The last 20 were written just now, as if since the
+-- dashboard's last refresh.
+INSERT INTO attendance (id, event_id, admission_no, event_type, ts, device_id, processed_at)
+SELECT g, gen_random_uuid(),
+       format('%s%s%s', 2020 + s % 5, (ARRAY['CS','EC','ME','CE','EE'])[1 + s % 5], lpad(s::text, 6, '0')),
+       CASE WHEN g % 2 = 0 THEN 'entry' ELSE 'exit' END,
+       t,
+       'bench-device-' || (g % 16),
+       LEAST(now() - interval '1 minute',
+             t + CASE WHEN g % 200 = 0 THEN interval '1 hour' + (g % 7) * interval '1 hour'
+                      ELSE (g % 3000) * interval '1 millisecond' END)
+FROM (
+  SELECT g,
+         1 + (g * 7919) % current_setting('bench.students')::int AS s,
+         now() - interval '365 days' + (g::float8 / current_setting('bench.rows')::int) * interval '365 days' - interval '2 minutes' AS t
+  FROM generate_series(1, current_setting('bench.rows')::int) g
+) e;
+UPDATE attendance SET processed_at = now()
+WHERE id > current_setting('bench.rows')::int - 20;
+
+CREATE INDEX ON attendance (ts DESC, id DESC);
+CREATE INDEX ON attendance (admission_no, ts DESC, id DESC);
+CREATE INDEX ON attendance (processed_at, id);
+ANALYZE students;
+ANALYZE attendance;
+
+CREATE FUNCTION time_query(q TEXT) RETURNS NUMERIC AS $$
+DECLARE
+  t0 TIMESTAMPTZ;
+  samples NUMERIC[] := '{}';
+BEGIN
+  EXECUTE q; -- warm the cache
+  FOR i IN 1..current_setting('bench.runs')::int LOOP
+    t0 := clock_timestamp();
+    EXECUTE q;
+    samples := samples || (extract(epoch FROM clock_timestamp() - t0) * 1000)::numeric;
+  END LOOP;
+  RETURN (SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY s) FROM unnest(samples) s)::numeric(10, 2);
+END;
+$$ LANGUAGE plpgsql;
+
+-- Rows and bytes the API would send back.
+CREATE FUNCTION result_size(q TEXT, OUT nrows BIGINT, OUT nbytes BIGINT) AS $$
+BEGIN
+  EXECUTE format('SELECT count(*), COALESCE(sum(pg_column_size(r)), 0) FROM (%s) r', q) INTO nrows, nbytes;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE results (query TEXT, before_ms NUMERIC, after_ms NUMERIC, before_rows BIGINT, after_rows BIGINT,
+                      before_bytes BIGINT, after_bytes BIGINT);
+
+CREATE FUNCTION record_result(label TEXT, q_before TEXT, q_after TEXT, untrigrammed_ms NUMERIC DEFAULT NULL) RETURNS VOID AS $$
+DECLARE
+  b RECORD;
+  a RECORD;
+BEGIN
+  SELECT * INTO b FROM result_size(q_before);
+  SELECT * INTO a FROM result_size(q_after);
+  INSERT INTO results VALUES (label, COALESCE(untrigrammed_ms, time_query(q_before)), time_query(q_after),
+                              b.nrows, a.nrows, b.nbytes, a.nbytes);
+END;
+$$ LANGUAGE plpgsql;
+
+DO $$
+DECLARE
+  search TEXT := 'SELECT admission_no, name, branch, year, created_at, rfid_uid FROM students WHERE admission_no ILIKE %L OR name ILIKE %L LIMIT 100';
+  terms TEXT[] := ARRAY['%quillfeather%', '%raghavan%', '%00042%', '%xyzzy%'];
+  labels TEXT[] := ARRAY['search: rare name', 'search: common surname', 'search: admission no fragment', 'search: no match'];
+  untrigrammed NUMERIC[] := '{}';
+  cols TEXT := 'SELECT a.id, a.admission_no, a.event_type, a.ts, a.device_id, a.processed_at, s.name '
+               'FROM attendance a LEFT JOIN students s ON a.admission_no = s.admission_no';
+  cursor_ts TIMESTAMPTZ;
+  cursor_id BIGINT;
+  since TIMESTAMPTZ;
+  depth INT;
+BEGIN
+  -- Student search, before and after the trigram indexes.
+  FOR i IN 1..array_length(terms, 1) LOOP
+    untrigrammed := untrigrammed || time_query(format(search, terms[i], terms[i]));
+  END LOOP;
+  CREATE INDEX ON students USING gin (name gin_trgm_ops);
+  CREATE INDEX ON students USING gin (admission_no gin_trgm_ops);
+  ANALYZE students;
+  FOR i IN 1..array_length(terms, 1) LOOP
+    PERFORM record_result(labels[i], format(search, terms[i], terms[i]), format(search, terms[i], terms[i]), untrigrammed[i]);
+  END LOOP;
+
+  -- Page N of 100 rows: OFFSET reads and discards every earlier row, the
+  -- keyset cursor starts at the previous page's last (ts, id).
+  FOREACH depth IN ARRAY ARRAY[10, 100, 1000] LOOP
+    EXECUTE format('SELECT ts, id FROM attendance ORDER BY ts DESC, id DESC OFFSET %s LIMIT 1', depth * 100 - 1)
+      INTO cursor_ts, cursor_id;
+    PERFORM record_result(format('attendance page %s (100 rows)', depth + 1),
+      format('%s ORDER BY a.ts DESC, a.id DESC LIMIT 100 OFFSET %s', cols, depth * 100),
+      format('%s WHERE (a.ts, a.id) < (%L::timestamptz, %s) ORDER BY a.ts DESC, a.id DESC LIMIT 100', cols, cursor_ts, cursor_id));
+  END LOOP;
+
+  -- Dashboard refresh after 20 new events: the newest 1000 again, or only
+  -- what was written since the last refresh (with the client's 5 s overlap).
+  since := now() - interval '5 seconds';
+  PERFORM record_result('refresh: newest 1000 vs updated_since',
+    format('%s ORDER BY a.ts DESC, a.id DESC LIMIT 1000', cols),
+    format('%s WHERE a.processed_at > %L::timestamptz ORDER BY a.processed_at, a.id LIMIT 200', cols, since));
+END;
+$$;
+
+\set QUIET off
+\echo
+SELECT pg_size_pretty(pg_total_relation_size('students')) AS students_size,
+       pg_size_pretty((SELECT sum(pg_total_relation_size(inhrelid)) FROM pg_inherits WHERE inhparent = 'attendance'::regclass)) AS attendance_size;
+SELECT query, before_ms, after_ms, round(before_ms / NULLIF(after_ms, 0), 1) AS speedup,
+       before_rows, after_rows, pg_size_pretty(before_bytes) AS before_bytes, pg_size_pretty(after_bytes) AS after_bytes
+FROM results;
+SQL
+
+if [[ "${KEEP}" != "1" ]]; then
+  run_psql -c "DROP SCHEMA bench_search CASCADE" >/dev/null
+fi
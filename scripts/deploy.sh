@@ -58,6 +58,10 @@ apply_migrations() {
     "${ROOT_DIR}/migrations/attendance.sql"
     "${ROOT_DIR}/migrations/02-grant-permissions.sql"
     "${ROOT_DIR}/migrations/03-add-rfid-uid.sql"
+    "${ROOT_DIR}/migrations/04-create-unassigned-rfid.sql"
+    "${ROOT_DIR}/migrations/05-create-rollups.sql"
+    "${ROOT_DIR}/migrations/06-partition-attendance.sql"
+    "${ROOT_DIR}/migrations/07-search-and-cursor-indexes.sql"
   )
 
   for migration in "${migrations[@]}"; do
@@ -0,0 +1,87 @@
+#!/usr/bin/env node
+
+/**
+ * Bulk-load a roster through POST /students/import.
+ *
+ * The CSV needs the header admission_no,name,branch,year,rfid_uid (branch,
+ * year and rfid_uid may be empty). The file is streamed to the admin API and
+ * validated and merged there in one transaction; nothing is applied if any
+ * row fails unless --skip-invalid is given.
+ *
+ * Usage:
+ *   node scripts/import-roster.js --file roster.csv [--dry-run] [--force] [--skip-invalid]
+ *
+ *   --dry-run       validate and report only
+ *   --force         take RFID UIDs over from other students, like register-rfid --force
+ *   --skip-invalid  merge the valid rows even when others fail
+ */
+
+const fs = require("fs")
+const { Readable } = require("stream")
+
+const args = process.argv.slice(2)
+const flags = new Set()
+const argMap = {}
+
+for (let i = 0; i < args.length; i += 1) {
+  const arg = args[i]
+  if (arg === "--dry-run" || arg === "--force" || arg === "--skip-invalid") {
+    flags.add(arg.replace(/^--/, ""))
+  } else if (arg.startsWith("--")) {
+    const value = args[i + 1]
+    if (!value || value.startsWith("--")) {
+      console.error(`Missing value for flag ${arg}`)
+      process.exit(1)
+    }
+    argMap[arg.replace(/^--/, "")] = value
+    i += 1
+  }
+}
+
+const apiBase = process.env.ADMIN_API_URL || "http://localhost:8001"
+
+async function main() {
+  const file = argMap.file || args.find((a) => !a.startsWith("--"))
+  if (!file || !fs.existsSync(file)) {
+    console.error("Usage: node scripts/import-roster.js --file roster.csv [--dry-run] [--force] [--skip-invalid]")
+    process.exit(1)
+  }
+
+  const params = new URLSearchParams({ report: "errors" })
+  if (flags.has("dry-run")) params.set("dry_run", "true")
+  if (flags.has("force")) params.set("force", "true")
+  if (flags.has("skip-invalid")) params.set("skip_invalid", "true")
+
+  const started = Date.now()
+  const res = await fetch(`${apiBase}/students/import?${params}`, {
+    method: "POST",
+    headers: { "Content-Type": "text/csv" },
+    body: Readable.toWeb(fs.createReadStream(file)),
+    duplex: "half",
+  })
+
+  if (res.status !== 200 && res.status !== 422) {
+    throw new Error(`${res.status} ${res.statusText}: ${await res.text()}`)
+  }
+
+  const result = await res.json()
+  for (const row of result.report) {
+    console.log(`line ${row.line}${row.admission_no ? ` (${row.admission_no})` : ""}: ${row.error}`)
+  }
+  console.log(
+    `\n${result.rows} rows in ${Date.now() - started} ms: ${result.inserted} new, ${result.updated} updated, ` +
+      `${result.errors} with errors`,
+  )
+  if (result.applied) {
+    console.log("Roster merged.")
+  } else {
+    console.log(flags.has("dry-run") ? "Dry run; nothing applied." : "Nothing applied.")
+  }
+  if (result.errors && !result.applied) process.exit(1)
+}
+
+main().catch((err) => {
+  console.error("Roster import failed:")
+  console.error(err.message || err)
+  process.exit(1)
+})